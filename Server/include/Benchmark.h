@@ -0,0 +1,22 @@
+#pragma once
+#include <string_view>
+
+class sqlite3DB;
+
+//Database console benchmarks, each takes the path of the schema file (sqlcrt.txt) followed by its own arguments
+
+//Compares request throughput of the in-memory database against file-backed storage
+//Arguments: <schema file> [requests]
+void benchmarkStorage(sqlite3DB& DB, const std::string_view& args);
+
+//Compares reading the parts of every service found by searchServices with a query per service against a single query
+//Arguments: <schema file> [services]
+void benchmarkServiceSearch(sqlite3DB& DB, const std::string_view& args);
+
+//Compares finding parts by name with LIKE against the in-memory parts catalogue searchParts uses, over a large catalogue
+//Arguments: <schema file> [parts]
+void benchmarkPartSearch(sqlite3DB& DB, const std::string_view& args);
+
+//Times writes made while threads read alongside them, either through the writer's connection or through connections of their own
+//Arguments: <schema file> [readers] [writes]
+void benchmarkConcurrentReads(sqlite3DB& DB, const std::string_view& args);
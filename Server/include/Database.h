@@ -5,6 +5,24 @@
 #include <cassert>
 #include <optional>
 #include <unordered_map>
+#include <list>
+#include <charconv>
+#include <iterator>
+#include <algorithm>
+#include <string_view>
+#include <variant>
+#include <array>
+#include <type_traits>
+#include <initializer_list>
+#include <limits>
+#include <chrono>
+#include <fstream>
+#include <filesystem>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <iostream>
+#include <cctype>
 
 
 //A simple wrapper around SQLite error codes
@@ -19,18 +37,233 @@ struct SQLCode final
     operator bool() const { return isOK(); }
 };
 
+//A single value to be bound to a statement parameter
+//Text values only view their source, which must outlive the query they are bound to
+class SQLValue
+{
+    std::variant<std::nullptr_t, int64_t, double, std::string_view> value;
+
+public:
+    SQLValue(std::nullptr_t = nullptr) : value(nullptr) {}
+    template <class T, std::enable_if_t<std::is_integral_v<T>, int> = 0>
+    SQLValue(T val) : value(static_cast<int64_t>(val)) {}
+    SQLValue(double val) : value(val) {}
+    SQLValue(std::string_view val) : value(val) {}
+    SQLValue(const char* val) : value(std::string_view(val)) {}
+    SQLValue(const std::string& val) : value(std::string_view(val)) {}
+
+    SQLCode bind(sqlite3_stmt* statement, int index) const
+    {
+        switch (value.index())
+        {
+        default:
+            return sqlite3_bind_null(statement, index);
+        case(1):
+            return sqlite3_bind_int64(statement, index, std::get<int64_t>(value));
+        case(2):
+            return sqlite3_bind_double(statement, index, std::get<double>(value));
+        case(3):
+        {
+            const auto& text = std::get<std::string_view>(value);
+            return sqlite3_bind_text(statement, index, text.data(), static_cast<int>(text.size()), SQLITE_STATIC);
+        }
+        }
+    }
+
+    //Appends the value to a key identifying a query and its arguments, tagged with its type so equal text and numbers stay distinct
+    void appendKey(std::string& key) const
+    {
+        key += static_cast<char>('0' + value.index());
+        char buffer[24];
+        switch (value.index())
+        {
+        default:
+            break;
+        case(1):
+            key.append(buffer, std::to_chars(std::begin(buffer), std::end(buffer), std::get<int64_t>(value)).ptr);
+            break;
+        case(2):
+        {
+            const double real = std::get<double>(value);
+            key.append(reinterpret_cast<const char*>(&real), sizeof(real));
+            break;
+        }
+        case(3):
+        {
+            //Text is prefixed with its length, so no text can run into the value after it
+            const auto& text = std::get<std::string_view>(value);
+            key.append(buffer, std::to_chars(std::begin(buffer), std::end(buffer), text.size()).ptr);
+            key += ':';
+            key.append(text);
+            break;
+        }
+        }
+        key += ';';
+    }
+};
+
+//Parses text from a request so that it binds as an integer (allowing integer key lookups), keeping the text if it is not a whole number
+inline SQLValue asInteger(std::string_view text)
+{
+    int64_t val;
+    const auto result = std::from_chars(text.data(), text.data() + text.size(), val);
+    if (result.ec != std::errc() || result.ptr != text.data() + text.size())
+        return text;
+    return val;
+}
+
+//A value bound either by its parameter's name or by its (1-based) position
+struct SQLParam
+{
+    int index = 0;
+    std::string_view name;
+    SQLValue value;
+
+    SQLParam() = default;
+    SQLParam(std::string_view paramName, SQLValue val) : name(paramName), value(val) {}
+    SQLParam(int position, SQLValue val) : index(position), value(val) {}
+};
+
+//A small, fixed-capacity set of parameters stored inline, so binding a query never allocates
+class SQLParams
+{
+public:
+    static constexpr size_t capacity = 8;
+
+private:
+    std::array<SQLParam, capacity> params;
+    size_t count = 0;
+    //Set if more parameters were added than could be stored, binding will then fail rather than silently dropping values
+    bool overflowed = false;
+
+public:
+    SQLParams() = default;
+    SQLParams(std::initializer_list<SQLParam> list)
+    {
+        for (const auto& i : list)
+            add(i);
+    }
+
+    void add(const SQLParam& param)
+    {
+        if (count == capacity)
+        {
+            overflowed = true;
+            return;
+        }
+        params[count++] = param;
+    }
+
+    bool valid() const { return !overflowed; }
+    auto begin() const { return params.cbegin(); }
+    auto end() const { return params.cbegin() + count; }
+};
+
+//A prepared statement along with its parameter names, which are resolved once when the statement is prepared
+struct preparedStatement
+{
+    sqlite3_stmt* statement = nullptr;
+    //Whether the statement leaves the database unchanged, statements which write must hold the database's write lock
+    bool readOnly = true;
+    //Entry i holds the name of parameter i + 1 (including its prefix), unnamed parameters are left empty
+    //Copied, as SQLite frees its own copy whenever it re-prepares the statement (such as to plan a LIKE for a new argument)
+    std::vector<std::string> parameterNames;
+    //Whether the statement's results may be kept in a result cache, only set for reads of tracked tables when the connection has one
+    bool cacheable = false;
+    //The tracked tables the statement reads, by their position in the tracked tables
+    std::vector<size_t> dependencies;
+
+    //Returns the 1-based index of a named parameter, or 0 if the statement has no such parameter
+    int parameterIndex(std::string_view name) const
+    {
+        for (size_t i = 0; i < parameterNames.size(); i++)
+        {
+            if (parameterNames[i] == name)
+                return static_cast<int>(i) + 1;
+        }
+        return 0;
+    }
+
+    //Binds each parameter with its own type, fails if a parameter does not exist in the statement
+    SQLCode bind(const SQLParams& params) const
+    {
+        if (!params.valid())
+            return SQLITE_RANGE;
+        for (const auto& i : params)
+        {
+            const int id = i.index != 0 ? i.index : parameterIndex(i.name);
+            if (id <= 0 || id > static_cast<int>(parameterNames.size()))
+                return SQLITE_RANGE;
+            const SQLCode status = i.value.bind(statement, id);
+            if (!status)
+                return status;
+        }
+        return SQLITE_OK;
+    }
+};
+
+//The storage class of a single value, matches SQLite's fundamental datatypes
+enum class SQLType : unsigned char
+{
+    integer = SQLITE_INTEGER,
+    real = SQLITE_FLOAT,
+    text = SQLITE_TEXT,
+    blob = SQLITE_BLOB,
+    null = SQLITE_NULL
+};
+
 //The result of a database query, only includes requested rows
 class SQLResult final
 {
+    //Numeric storage for a single cell, the member in use is given by the cell's type
+    union numeric
+    {
+        int64_t integer;
+        double real;
+    };
+
+    //Values are stored column by column so typed columns stay contiguous
+    struct column
+    {
+        std::vector<SQLType> types;
+        std::vector<numeric> numbers;
+    };
+
     size_t colCount;
-    //Store elements continuously to save some space and provide more cache friendly linear access (despite double deref from strings)
-    std::vector<std::string> data;
+    size_t rows = 0;
+    std::vector<column> columns;
     std::vector<std::string> colNames;
 
+    //Text form of every cell (numeric cells are rendered once for the string accessors), stored back to back in row order
+    std::string arena;
+    //Start of each cell within the arena, with one trailing entry marking the end of the final cell
+    std::vector<size_t> offsets{ 0 };
+
+    //Grows the arena and offsets ahead of the next row, using the rows seen so far to estimate what is still to come
+    void reserveRow(size_t incomingBytes)
+    {
+        if (arena.size() + incomingBytes > arena.capacity())
+        {
+            const size_t averageRow = rows == 0 ? incomingBytes : arena.size() / rows;
+            arena.reserve(std::max(arena.capacity() * 2, arena.size() + averageRow * std::max<size_t>(rows, 1)));
+        }
+        if (offsets.size() + colCount > offsets.capacity())
+        {
+            offsets.reserve(offsets.capacity() * 2 + colCount);
+        }
+    }
+
+    void appendText(std::string_view text)
+    {
+        arena.append(text.data(), text.size());
+        offsets.push_back(arena.size());
+    }
+
     [[nodiscard]]
     SQLCode execute(sqlite3_stmt* statement)
     {
         int status;
+        std::vector<SQLType> rowTypes(static_cast<size_t>(colCount));
         while (true)
         {
             status = sqlite3_step(statement);
@@ -38,17 +271,63 @@ class SQLResult final
             //The statement can be repeatedly looped until status stops being SQLITE_ROW, at which point it is either SQLITE_OK or an error code
             if (status == SQLITE_ROW)
             {
+                //The types must be read before any other column function, as they may convert the value
+                //Only text and blobs are sized by SQLite, numbers are given the most their text form can take
+                size_t incomingBytes = 0;
+                for (int i = 0; i < colCount; i++)
+                {
+                    rowTypes[i] = static_cast<SQLType>(sqlite3_column_type(statement, i));
+                    switch (rowTypes[i])
+                    {
+                    case(SQLType::integer):
+                    case(SQLType::real):
+                        incomingBytes += 24;
+                        break;
+                    case(SQLType::null):
+                        incomingBytes += 4;
+                        break;
+                    default:
+                        incomingBytes += static_cast<size_t>(sqlite3_column_bytes(statement, i));
+                        break;
+                    }
+                }
+                reserveRow(incomingBytes);
+
                 for (int i = 0; i < colCount; i++)
                 {
-                    const auto val = sqlite3_column_text(statement, i);
-                    if (val == nullptr)
-                        data.emplace_back("NULL");
-                    else
+                    auto& col = columns[i];
+                    const auto type = rowTypes[i];
+                    numeric number{};
+
+                    switch (type)
+                    {
+                    case(SQLType::integer):
+                    {
+                        number.integer = sqlite3_column_int64(statement, i);
+                        char buffer[24];
+                        const auto end = std::to_chars(std::begin(buffer), std::end(buffer), number.integer).ptr;
+                        appendText({ buffer, static_cast<size_t>(end - buffer) });
+                        break;
+                    }
+                    case(SQLType::null):
+                        appendText("NULL");
+                        break;
+                    case(SQLType::real):
+                        number.real = sqlite3_column_double(statement, i);
+                        [[fallthrough]];
+                    default:
                     {
                         //Cast from unsigned char array to singed char array
-                        data.emplace_back(reinterpret_cast<const char* const>(val));
+                        const auto val = reinterpret_cast<const char*>(sqlite3_column_text(statement, i));
+                        appendText({ val, static_cast<size_t>(sqlite3_column_bytes(statement, i)) });
+                        break;
+                    }
                     }
+
+                    col.types.push_back(type);
+                    col.numbers.push_back(number);
                 }
+                rows++;
             }
             else
             {
@@ -56,8 +335,6 @@ class SQLResult final
             }
         }
 
-        sqlite3_finalize(statement);
-
         if (status == SQLITE_DONE)
         {
             return SQLCode(SQLITE_OK);
@@ -66,11 +343,15 @@ class SQLResult final
 
     }
 
-    const std::string& get(size_t row, size_t col) const { return data[row * colCount + col]; }
+    std::string_view get(size_t row, size_t col) const
+    {
+        const size_t cell = row * colCount + col;
+        return std::string_view(arena.data() + offsets[cell], offsets[cell + 1] - offsets[cell]);
+    }
 
     //Public construction not allowed, static function must be used
     SQLResult() = delete;
-    SQLResult(int size) : colCount(size) {}
+    SQLResult(int size) : colCount(size), columns(size) {}
 
     //Allows for [x][y] style access
     class accessWrapper
@@ -80,35 +361,20 @@ class SQLResult final
     public:
         accessWrapper(const SQLResult& obj, size_t targetRow) : result(obj), row(targetRow) {}
 
-        const std::string& operator[](size_t col) const { return result.get(row, col); }
+        std::string_view operator[](size_t col) const { return result.get(row, col); }
     };
 
 public:
 
-    static std::pair<SQLCode, const SQLResult> query(sqlite3* database, std::string_view SQL, const std::unordered_map<std::string_view, std::string_view>& namedParams)
+    //Binds and executes an already prepared statement, the statement is left for the caller to reset or finalize
+    static std::pair<SQLCode, SQLResult> query(const preparedStatement& prepared, const SQLParams& params)
     {
-        sqlite3_stmt* statement = nullptr;
-        assert(SQL.size() <= std::numeric_limits<int>::max());
-        sqlite3_prepare_v2(database, SQL.data(), static_cast<int>(SQL.size()), &statement, nullptr);
-        //Statement is not assigned a value if SQL parsing fails
-        if (statement == nullptr)
+        if (const SQLCode bound = prepared.bind(params); !bound)
         {
-            return { SQLITE_ERROR, SQLResult(0) };
+            return { bound, SQLResult(0) };
         }
 
-        const auto m = sqlite3_bind_parameter_count(statement);
-
-        for (const auto& [name, value] : namedParams)
-        {
-            int id = sqlite3_bind_parameter_index(statement, name.data());
-            if (id != 0)
-                sqlite3_bind_text(statement, id, value.data(), static_cast<int>(value.size()), SQLITE_STATIC);
-            else
-            {
-                sqlite3_finalize(statement);
-                return { SQLITE_ERROR, SQLResult(0) };
-            }
-        }
+        sqlite3_stmt* statement = prepared.statement;
 
         SQLResult ret(sqlite3_column_count(statement));
 
@@ -119,42 +385,906 @@ public:
         }
 
         const SQLCode res = ret.execute(statement);
-        return { res, ret };
+        return { res, std::move(ret) };
+    }
+
+    //An empty result, used when no statement could be prepared
+    static SQLResult empty() { return SQLResult(0); }
+
+    //Approximately how many bytes the result holds, including its allocations
+    size_t memoryUsage() const
+    {
+        size_t ret = sizeof(SQLResult) + arena.capacity() + offsets.capacity() * sizeof(size_t);
+        for (const auto& i : columns)
+        {
+            ret += sizeof(column) + i.types.capacity() * sizeof(SQLType) + i.numbers.capacity() * sizeof(numeric);
+        }
+        for (const auto& i : colNames)
+        {
+            ret += sizeof(std::string) + i.capacity();
+        }
+        return ret;
     }
 
     size_t columnCount() const { return colCount; }
-    size_t rowCount() const { return data.size() / colCount; }
+    size_t rowCount() const { return rows; }
 
     const accessWrapper operator[](size_t row) const { return accessWrapper(*this, row); }
 
     const std::string& getColName(size_t col) const { return colNames[col]; }
+
+    SQLType getType(size_t row, size_t col) const { return columns[col].types[row]; }
+    bool isNull(size_t row, size_t col) const { return getType(row, col) == SQLType::null; }
+
+    //Only succeeds for values stored as integers, no text is parsed
+    std::optional<int64_t> getInteger(size_t row, size_t col) const
+    {
+        if (getType(row, col) != SQLType::integer)
+            return std::nullopt;
+        return columns[col].numbers[row].integer;
+    }
+
+    //Succeeds for both real and integer values, no text is parsed
+    std::optional<double> getReal(size_t row, size_t col) const
+    {
+        switch (getType(row, col))
+        {
+        case(SQLType::real):
+            return columns[col].numbers[row].real;
+        case(SQLType::integer):
+            return static_cast<double>(columns[col].numbers[row].integer);
+        default:
+            return std::nullopt;
+        }
+    }
+};
+
+//A bounded least-recently-used cache of prepared statements, keyed by their SQL text
+//Statements are checked out of the cache while in use, so nested queries never share a statement
+class statementCache final
+{
+    using entry = std::pair<std::string, preparedStatement>;
+
+    //Most recently used statements are kept at the front
+    std::list<entry> entries;
+    //Keys view the strings held in entries, list nodes never move so these remain valid
+    std::unordered_map<std::string_view, std::list<entry>::iterator> lookup;
+    //Initialised here as well, the move constructor swaps every member with the moved-from cache
+    size_t capacity = 0;
+
+    uint64_t hits = 0, misses = 0, evictions = 0;
+
+    //Statements are taken and returned by every thread using the database
+    mutable std::mutex lock;
+
+public:
+    struct statistics
+    {
+        uint64_t hits = 0, misses = 0, evictions = 0;
+        size_t size = 0, capacity = 0;
+    };
+
+    statementCache(size_t maxSize) : capacity(maxSize) {}
+
+    statementCache(const statementCache&) = delete;
+    statementCache(statementCache&& move) noexcept
+    {
+        *this = std::move(move);
+    }
+
+    statementCache& operator=(const statementCache&) = delete;
+    statementCache& operator=(statementCache&& move) noexcept
+    {
+        std::scoped_lock guard(lock, move.lock);
+        std::swap(entries, move.entries);
+        std::swap(lookup, move.lookup);
+        std::swap(capacity, move.capacity);
+        std::swap(hits, move.hits);
+        std::swap(misses, move.misses);
+        std::swap(evictions, move.evictions);
+        return *this;
+    }
+
+    ~statementCache()
+    {
+        clear();
+    }
+
+    //Removes a statement from the cache for use, the returned statement is null if no matching statement is available
+    preparedStatement acquire(std::string_view SQL)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        const auto it = lookup.find(SQL);
+        if (it == lookup.end())
+        {
+            misses++;
+            return {};
+        }
+        hits++;
+        preparedStatement ret = std::move(it->second->second);
+        entries.erase(it->second);
+        lookup.erase(it);
+        return ret;
+    }
+
+    //Returns a statement to the cache, resetting it and clearing any bindings so it is ready for reuse
+    void release(std::string_view SQL, preparedStatement&& prepared)
+    {
+        sqlite3_reset(prepared.statement);
+        sqlite3_clear_bindings(prepared.statement);
+
+        std::lock_guard<std::mutex> guard(lock);
+        //The same SQL may have been prepared twice if it was in use by an outer query, only one copy is kept
+        if (capacity == 0 || lookup.count(SQL) != 0)
+        {
+            sqlite3_finalize(prepared.statement);
+            return;
+        }
+
+        entries.emplace_front(std::string(SQL), std::move(prepared));
+        lookup.emplace(entries.front().first, entries.begin());
+
+        if (entries.size() > capacity)
+        {
+            lookup.erase(entries.back().first);
+            sqlite3_finalize(entries.back().second.statement);
+            entries.pop_back();
+            evictions++;
+        }
+    }
+
+    //Finalizes every cached statement, must be called before the owning database is closed
+    void clear()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        for (auto& [SQL, prepared] : entries)
+        {
+            sqlite3_finalize(prepared.statement);
+        }
+        lookup.clear();
+        entries.clear();
+    }
+
+    statistics getStatistics() const
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return { hits, misses, evictions, entries.size(), capacity };
+    }
+};
+
+//The generations of every tracked table at one moment, in the order the tables were given
+using generationSnapshot = std::vector<uint64_t>;
+
+//Counts the committed changes to each of a set of tables, so anything holding data read from a table can cheaply tell whether it has since changed
+//Changes are recorded as rows are written (by SQLite's update hook) but only published once their transaction has finished, a reader which sees a new generation therefore also sees the data behind it
+//Rolled back changes are published as well, a generation may move without the data changing but never the other way around
+class tableGenerations final
+{
+    std::vector<std::string> names;
+    //Keys view the strings held in names, which never change once constructed
+    std::unordered_map<std::string_view, size_t> lookup;
+    std::unique_ptr<std::atomic<uint64_t>[]> counters;
+    //Tables changed by writes not yet published, only used by the thread holding the database's write lock
+    std::vector<bool> pending;
+    bool anyPending = false;
+
+    static void onUpdate(void* owner, int, const char*, const char* table, sqlite3_int64)
+    {
+        static_cast<tableGenerations*>(owner)->changed(table);
+    }
+
+public:
+    explicit tableGenerations(const std::vector<std::string>& tables) :
+        names(tables), counters(std::make_unique<std::atomic<uint64_t>[]>(tables.size())), pending(tables.size(), false)
+    {
+        for (size_t i = 0; i < names.size(); i++)
+        {
+            lookup.emplace(names[i], i);
+            counters[i].store(1, std::memory_order_relaxed);
+        }
+    }
+
+    //Refers to itself through lookup, and to SQLite through the hook, so cannot be copied or moved
+    tableGenerations(const tableGenerations&) = delete;
+    tableGenerations& operator=(const tableGenerations&) = delete;
+
+    //Starts recording the changes made through a connection
+    void attach(sqlite3* database)
+    {
+        sqlite3_update_hook(database, onUpdate, this);
+    }
+
+    //The position of a tracked table, if the table is tracked
+    std::optional<size_t> find(std::string_view table) const
+    {
+        auto it = lookup.find(table);
+        //Full text indexes (named "<table>_SEARCH") are written, and read, through FTS5's shadow tables ("<index>_data" and so on)
+        if (it == lookup.end())
+        {
+            static const std::array<std::string_view, 5> shadowSuffixes{ "_data", "_idx", "_content", "_docsize", "_config" };
+            constexpr std::string_view indexSuffix = "_SEARCH";
+            const auto endsWith = [](std::string_view text, std::string_view end) { return text.size() > end.size() && text.substr(text.size() - end.size()) == end; };
+            for (const auto suffix : shadowSuffixes)
+            {
+                if (!endsWith(table, suffix))
+                    continue;
+                const auto index = table.substr(0, table.size() - suffix.size());
+                if (endsWith(index, indexSuffix))
+                    it = lookup.find(index);
+                break;
+            }
+            if (it == lookup.end())
+                return std::nullopt;
+        }
+        return it->second;
+    }
+
+    //Records a change to a table, tables which are not tracked are ignored
+    void changed(std::string_view table)
+    {
+        const auto position = find(table);
+        if (!position.has_value())
+            return;
+        pending[*position] = true;
+        anyPending = true;
+    }
+
+    //Records a change to every table, for writes SQLite does not report (such as restoring an image)
+    void changedAll()
+    {
+        std::fill(pending.begin(), pending.end(), true);
+        anyPending = !pending.empty();
+    }
+
+    //Moves every changed table on to its next generation, unless the connection is still inside a transaction
+    void publish(sqlite3* database)
+    {
+        if (!anyPending || sqlite3_get_autocommit(database) == 0)
+            return;
+        for (size_t i = 0; i < pending.size(); i++)
+        {
+            if (pending[i])
+                counters[i].fetch_add(1, std::memory_order_release);
+        }
+        std::fill(pending.begin(), pending.end(), false);
+        anyPending = false;
+    }
+
+    size_t size() const
+    {
+        return names.size();
+    }
+
+    //Safe to call from any thread
+    uint64_t get(size_t table) const
+    {
+        return table < names.size() ? counters[table].load(std::memory_order_acquire) : 0;
+    }
+
+    //Each table's generation is read separately, so a snapshot taken while a write is being published may hold only part of it
+    generationSnapshot snapshot() const
+    {
+        generationSnapshot ret(names.size());
+        for (size_t i = 0; i < names.size(); i++)
+        {
+            ret[i] = get(i);
+        }
+        return ret;
+    }
+};
+
+//The database's write lock, a write has finished (been committed or rolled back) once its thread last releases the lock
+//So the tables it changed are published at that point
+class writerMutex final
+{
+    std::recursive_mutex mutex;
+    //How many times the owning thread currently holds the lock, only used by that thread
+    size_t depth = 0;
+    sqlite3* database = nullptr;
+    tableGenerations* generations = nullptr;
+
+public:
+    void lock()
+    {
+        mutex.lock();
+        depth++;
+    }
+
+    bool try_lock()
+    {
+        if (!mutex.try_lock())
+            return false;
+        depth++;
+        return true;
+    }
+
+    void unlock()
+    {
+        if (--depth == 0 && generations != nullptr)
+            generations->publish(database);
+        mutex.unlock();
+    }
+
+    void track(sqlite3* db, tableGenerations* tables)
+    {
+        std::lock_guard<std::recursive_mutex> guard(mutex);
+        database = db;
+        generations = tables;
+    }
+};
+
+//A bounded least-recently-used cache of read queries' results, keyed by their SQL and bound values
+//Each result remembers the generations of the tables it was read from, and is dropped as soon as any of them has moved on
+//Shared by every connection to the database, so a result read on one thread answers the same query on any other
+class queryResultCache final
+{
+public:
+    //A tracked table read by a query, with its generation from before the query ran
+    using dependency = std::pair<size_t, uint64_t>;
+
+private:
+    struct entry
+    {
+        std::string key;
+        //Shared so a hit can be copied out without holding the cache's lock
+        std::shared_ptr<const SQLResult> result;
+        std::vector<dependency> dependencies;
+        size_t bytes = 0;
+    };
+
+    std::shared_ptr<const tableGenerations> generations;
+    //Most recently used results are kept at the front
+    std::list<entry> entries;
+    //Keys view the strings held in entries, list nodes never move so these remain valid
+    std::unordered_map<std::string_view, std::list<entry>::iterator> lookup;
+    size_t budget;
+    size_t used = 0;
+
+    uint64_t hits = 0, misses = 0, invalidations = 0, evictions = 0;
+
+    //Results are found and stored by every thread reading the database
+    mutable std::mutex lock;
+
+    void erase(std::list<entry>::iterator it)
+    {
+        used -= it->bytes;
+        lookup.erase(it->key);
+        entries.erase(it);
+    }
+
+public:
+    struct statistics
+    {
+        uint64_t hits = 0, misses = 0, invalidations = 0, evictions = 0;
+        size_t size = 0, bytes = 0, budget = 0;
+    };
+
+    queryResultCache(std::shared_ptr<const tableGenerations> tables, size_t maxBytes) : generations(std::move(tables)), budget(maxBytes) {}
+
+    queryResultCache(const queryResultCache&) = delete;
+    queryResultCache& operator=(const queryResultCache&) = delete;
+
+    //Identifies a query by its SQL and the values bound to it
+    static std::string key(std::string_view SQL, const SQLParams& params)
+    {
+        std::string ret(SQL);
+        for (const auto& i : params)
+        {
+            ret += '\0';
+            if (i.index != 0)
+                ret += std::to_string(i.index);
+            else
+                ret.append(i.name);
+            ret += '=';
+            i.value.appendKey(ret);
+        }
+        return ret;
+    }
+
+    //Resolves the tables a statement reads to their positions, fails if any of them is not tracked
+    bool resolve(const std::vector<std::string>& tables, std::vector<size_t>& positions) const
+    {
+        positions.clear();
+        for (const auto& i : tables)
+        {
+            const auto position = generations->find(i);
+            if (!position.has_value())
+                return false;
+            if (std::find(positions.begin(), positions.end(), *position) == positions.end())
+                positions.push_back(*position);
+        }
+        return true;
+    }
+
+    //Reads the generations a result will be stored against, must be called before its query runs
+    //A write committed while the query runs then leaves the result already out of date, rather than stored as current
+    std::vector<dependency> stamp(const std::vector<size_t>& tables) const
+    {
+        std::vector<dependency> ret;
+        ret.reserve(tables.size());
+        for (const size_t i : tables)
+        {
+            ret.emplace_back(i, generations->get(i));
+        }
+        return ret;
+    }
+
+    //A copy of the result stored for the key, provided none of the tables it was read from have changed since
+    std::optional<SQLResult> find(const std::string& key)
+    {
+        std::shared_ptr<const SQLResult> found;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            const auto it = lookup.find(key);
+            if (it == lookup.end())
+            {
+                misses++;
+                return std::nullopt;
+            }
+            for (const auto& [table, generation] : it->second->dependencies)
+            {
+                if (generations->get(table) != generation)
+                {
+                    erase(it->second);
+                    invalidations++;
+                    misses++;
+                    return std::nullopt;
+                }
+            }
+            hits++;
+            entries.splice(entries.begin(), entries, it->second);
+            found = entries.front().result;
+        }
+        return *found;
+    }
+
+    //Keeps a result, replacing any already held for the key, then evicts the least recently used results until within budget
+    //Results larger than the whole budget are not kept
+    void store(std::string key, const SQLResult& result, std::vector<dependency> dependencies)
+    {
+        const size_t bytes = sizeof(entry) + key.size() * 2 + result.memoryUsage() + dependencies.size() * sizeof(dependency);
+        if (bytes > budget)
+            return;
+        auto stored = std::make_shared<const SQLResult>(result);
+
+        std::lock_guard<std::mutex> guard(lock);
+        if (const auto it = lookup.find(key); it != lookup.end())
+            erase(it->second);
+
+        entries.push_front({ std::move(key), std::move(stored), std::move(dependencies), bytes });
+        lookup.emplace(entries.front().key, entries.begin());
+        used += bytes;
+
+        while (used > budget)
+        {
+            erase(std::prev(entries.end()));
+            evictions++;
+        }
+    }
+
+    statistics getStatistics() const
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return { hits, misses, invalidations, evictions, entries.size(), used, budget };
+    }
+};
+
+//A forward-only view over the rows of a statement, rows are read as they are stepped rather than stored
+//Values read from a row are only valid until the next call to next()
+class SQLCursor final
+{
+    preparedStatement prepared;
+    //The cache the statement is returned to once the cursor is finished with
+    statementCache* owner = nullptr;
+    std::string SQL;
+    int status = SQLITE_OK;
+    //Only held by cursors over statements which write
+    std::unique_lock<writerMutex> writeLock;
+
+    void tidy()
+    {
+        if (prepared.statement != nullptr)
+        {
+            owner->release(SQL, std::move(prepared));
+            prepared = {};
+        }
+        if (writeLock.owns_lock())
+            writeLock.unlock();
+    }
+
+public:
+    SQLCursor(int error) : status(error) {}
+    SQLCursor(preparedStatement&& stmt, statementCache& cache, std::string_view source, std::unique_lock<writerMutex>&& lock) :
+        prepared(std::move(stmt)), owner(&cache), SQL(source), writeLock(std::move(lock)) {}
+
+    SQLCursor(const SQLCursor&) = delete;
+    SQLCursor(SQLCursor&& move) noexcept
+    {
+        *this = std::move(move);
+    }
+
+    SQLCursor& operator=(const SQLCursor&) = delete;
+    SQLCursor& operator=(SQLCursor&& move) noexcept
+    {
+        std::swap(prepared, move.prepared);
+        std::swap(owner, move.owner);
+        std::swap(SQL, move.SQL);
+        std::swap(status, move.status);
+        std::swap(writeLock, move.writeLock);
+        return *this;
+    }
+
+    ~SQLCursor()
+    {
+        tidy();
+    }
+
+    //Steps to the next row, returns false once all rows have been read or an error occurred
+    bool next()
+    {
+        if (prepared.statement == nullptr)
+            return false;
+        const int result = sqlite3_step(prepared.statement);
+        if (result == SQLITE_ROW)
+            return true;
+
+        status = result == SQLITE_DONE ? SQLITE_OK : result;
+        //The statement is no longer needed, so may be reused by any later query
+        tidy();
+        return false;
+    }
+
+    //Either the error that stopped the cursor, or OK
+    SQLCode getStatus() const { return status; }
+    operator bool() const { return getStatus(); }
+
+    size_t columnCount() const { return prepared.statement == nullptr ? 0 : static_cast<size_t>(sqlite3_column_count(prepared.statement)); }
+    std::string_view getColName(size_t col) const { return sqlite3_column_name(prepared.statement, static_cast<int>(col)); }
+
+    SQLType getType(size_t col) const { return static_cast<SQLType>(sqlite3_column_type(prepared.statement, static_cast<int>(col))); }
+    bool isNull(size_t col) const { return getType(col) == SQLType::null; }
+
+    //Text form of a value, NULL values are given as "NULL" to match SQLResult
+    std::string_view operator[](size_t col) const
+    {
+        const auto val = reinterpret_cast<const char*>(sqlite3_column_text(prepared.statement, static_cast<int>(col)));
+        if (val == nullptr)
+            return "NULL";
+        return std::string_view(val, static_cast<size_t>(sqlite3_column_bytes(prepared.statement, static_cast<int>(col))));
+    }
+
+    std::optional<int64_t> getInteger(size_t col) const
+    {
+        if (getType(col) != SQLType::integer)
+            return std::nullopt;
+        return sqlite3_column_int64(prepared.statement, static_cast<int>(col));
+    }
+
+    std::optional<double> getReal(size_t col) const
+    {
+        const auto type = getType(col);
+        if (type != SQLType::real && type != SQLType::integer)
+            return std::nullopt;
+        return sqlite3_column_double(prepared.statement, static_cast<int>(col));
+    }
+};
+
+//Scoped transaction, rolled back when it leaves scope unless it was committed
+//The outermost guard takes the write lock up front (BEGIN IMMEDIATE), any guard opened while a transaction is already running becomes a savepoint within it
+//The database's write lock is held for the guard's lifetime, so only the owning thread may use the guard
+class SQLTransaction final
+{
+    sqlite3* database = nullptr;
+    //Savepoints share one name, SQLite always resolves it to the innermost one
+    bool nested = false;
+    SQLCode status = SQLITE_MISUSE;
+    std::unique_lock<writerMutex> writeLock;
+
+    SQLCode execute(const char* SQL)
+    {
+        return sqlite3_exec(database, SQL, nullptr, nullptr, nullptr);
+    }
+
+    //Marks the transaction as finished and lets other threads write
+    void finish()
+    {
+        database = nullptr;
+        if (writeLock.owns_lock())
+            writeLock.unlock();
+    }
+
+public:
+    SQLTransaction() = default;
+    SQLTransaction(sqlite3* db, writerMutex& writer) : database(db)
+    {
+        if (database == nullptr)
+            return;
+        //With the lock held, any transaction already running on the connection must be this thread's own
+        writeLock = std::unique_lock<writerMutex>(writer);
+        nested = sqlite3_get_autocommit(database) == 0;
+        status = execute(nested ? "SAVEPOINT nested" : "BEGIN IMMEDIATE");
+        if (!status)
+            finish();
+    }
+
+    SQLTransaction(const SQLTransaction&) = delete;
+    SQLTransaction(SQLTransaction&& move) noexcept
+    {
+        *this = std::move(move);
+    }
+
+    SQLTransaction& operator=(const SQLTransaction&) = delete;
+    SQLTransaction& operator=(SQLTransaction&& move) noexcept
+    {
+        std::swap(database, move.database);
+        std::swap(nested, move.nested);
+        std::swap(status, move.status);
+        std::swap(writeLock, move.writeLock);
+        return *this;
+    }
+
+    ~SQLTransaction()
+    {
+        rollback();
+    }
+
+    //Whether the transaction was started and is still waiting to be committed or rolled back
+    bool isActive() const
+    {
+        return database != nullptr;
+    }
+    operator bool() const
+    {
+        return isActive();
+    }
+
+    //The result of beginning the transaction
+    SQLCode getStatus() const
+    {
+        return status;
+    }
+
+    //Makes the changes permanent (or, for a savepoint, part of the enclosing transaction)
+    //If the commit fails the changes are rolled back
+    SQLCode commit()
+    {
+        if (database == nullptr)
+            return SQLITE_MISUSE;
+
+        const SQLCode result = execute(nested ? "RELEASE nested" : "COMMIT");
+        if (!result)
+        {
+            rollback();
+            return result;
+        }
+        finish();
+        return result;
+    }
+
+    //Discards every change made since the transaction began, does nothing if it has already finished
+    void rollback()
+    {
+        if (database == nullptr)
+            return;
+
+        if (nested)
+        {
+            //Rolling back to a savepoint leaves it open, so it must also be released
+            execute("ROLLBACK TO nested");
+            execute("RELEASE nested");
+        }
+        //A failed statement may already have rolled the transaction back
+        else if (sqlite3_get_autocommit(database) == 0)
+        {
+            execute("ROLLBACK");
+        }
+        finish();
+    }
+};
+
+//A named in-memory database, shared by every connection in the process which opens it
+//The server only opens it through the writer: without a write-ahead log, any other connection's read would lock the writer out
+constexpr std::string_view sharedMemoryDatabase = "file:/WFA?vfs=memdb";
+
+//Storage options for a file-backed database
+struct databaseSettings
+{
+    //The database file, empty for an in-memory database (which ignores the remaining options)
+    std::string file;
+    //Bytes of the file to memory-map for reads, 0 disables memory-mapping
+    int64_t mmapSize = 256 * 1024 * 1024;
+    //Page cache size, positive values are a number of pages and negative values a number of KiB (as PRAGMA cache_size)
+    int64_t cacheSize = -64 * 1024;
+    //Where temporary tables and indices are kept, 0 is SQLite's default, 1 a file and 2 memory (as PRAGMA temp_store)
+    int tempStore = 2;
+    //How often the write-ahead log is checkpointed away from the network thread, 0 leaves it to SQLite's automatic checkpoints
+    std::chrono::seconds checkpointInterval{ 30 };
+
+    //An in-memory database is periodically written to this file and restored from it at startup, empty to disable
+    std::string snapshotFile;
+    //How often the snapshot is rewritten, 0 only writes it on shutdown
+    std::chrono::seconds snapshotInterval{ 60 };
+
+    //Threads running routes' database work away from the network loop, each reading through its own connection to a file-backed database
+    size_t executorThreads = 2;
+
+    //Statements are checked as they are first prepared and any full scan of a table with at least this many rows reported, negative disables the audit
+    int64_t planAuditRows = -1;
+
+    //Bytes of query results kept for the reads which use the result cache, 0 disables the cache
+    size_t resultCacheBytes = 32 * 1024 * 1024;
+
+    bool isFileBacked() const
+    {
+        return !file.empty();
+    }
+
+    //What the server's connections open, the file or the shared in-memory database
+    std::string_view source() const
+    {
+        return isFileBacked() ? std::string_view(file) : sharedMemoryDatabase;
+    }
 };
 
 //Represents a database
+//Safe to use from several threads at once: reads run side by side (interleaved by SQLite's own connection lock), while writes and transactions take turns
+//Reads share the connection with writes, so a read may see the changes of a transaction another thread has not yet committed
 class sqlite3DB final
 {
     sqlite3* database;
+    statementCache statements{ defaultStatementCacheSize };
+    //Held by every statement which writes and for the whole of a transaction, otherwise one thread's writes would join another thread's transaction
+    //Kept behind a pointer so the database can still be moved
+    std::unique_ptr<writerMutex> writer = std::make_unique<writerMutex>();
+    int64_t planAuditRows = -1;
+    //Null until trackTables is called
+    std::shared_ptr<tableGenerations> tracked;
+    //Null unless a result cache is enabled or shared with the connection
+    std::shared_ptr<queryResultCache> results;
+
+    //What a statement reads, gathered by the authorizer as the statement is prepared
+    struct statementReads
+    {
+        std::vector<std::string> tables;
+        //Cleared by functions which can give a different answer for the same data (the time, random numbers)
+        bool deterministic = true;
+    };
+    //Set by the thread preparing a statement, SQLite calls the authorizer on that same thread
+    static inline thread_local statementReads* collecting = nullptr;
+
+    static int collectReads(void*, int action, const char* third, const char* fourth, const char*, const char*)
+    {
+        if (collecting == nullptr)
+            return SQLITE_OK;
+        if (action == SQLITE_READ && third != nullptr)
+        {
+            //SQLite's own tables are read as a connection first loads the schema, they hold no data a result depends on
+            if (std::string_view(third).substr(0, 7) == "sqlite_")
+                return SQLITE_OK;
+            if (std::find(collecting->tables.begin(), collecting->tables.end(), third) == collecting->tables.end())
+                collecting->tables.emplace_back(third);
+        }
+        else if (action == SQLITE_FUNCTION && fourth != nullptr)
+        {
+            static const std::array<std::string_view, 13> volatileFunctions{ "random", "randomblob", "changes", "total_changes", "last_insert_rowid",
+                "date", "time", "datetime", "julianday", "unixepoch", "strftime", "current_date", "current_timestamp" };
+            std::string name(fourth);
+            std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            if (name == "current_time" || std::find(volatileFunctions.begin(), volatileFunctions.end(), name) != volatileFunctions.end())
+                collecting->deterministic = false;
+        }
+        return SQLITE_OK;
+    }
+
+    //Resolves the names a query plan refers to (aliases as well as tables) to the tables they read
+    //The routes always alias with "AS", so the SQL's "<table> AS <alias>" pairs are enough
+    static std::unordered_map<std::string, std::string> tableAliases(std::string_view SQL)
+    {
+        std::vector<std::string_view> words;
+        size_t start = 0;
+        for (size_t i = 0; i <= SQL.size(); i++)
+        {
+            const bool wordChar = i < SQL.size() && (std::isalnum(static_cast<unsigned char>(SQL[i])) || SQL[i] == '_');
+            if (!wordChar)
+            {
+                if (i > start)
+                    words.push_back(SQL.substr(start, i - start));
+                start = i + 1;
+            }
+        }
+
+        std::unordered_map<std::string, std::string> ret;
+        for (size_t i = 1; i + 1 < words.size(); i++)
+        {
+            if (words[i].size() == 2 && std::toupper(static_cast<unsigned char>(words[i][0])) == 'A' && std::toupper(static_cast<unsigned char>(words[i][1])) == 'S')
+                ret.emplace(words[i + 1], words[i - 1]);
+        }
+        return ret;
+    }
+
+    //An in-memory (memdb) database is otherwise limited to SQLite's default maximum (1GiB)
+    void liftSizeLimit()
+    {
+        sqlite3_int64 limit = std::numeric_limits<sqlite3_int64>::max();
+        sqlite3_file_control(database, "main", SQLITE_FCNTL_SIZE_LIMIT, &limit);
+    }
+
+    //Runs a prepared statement to completion, holding the write lock unless it only reads, then returns it to the statement cache
+    std::pair<SQLCode, SQLResult> execute(std::string_view SQL, preparedStatement&& prepared, const SQLParams& params)
+    {
+        std::unique_lock<writerMutex> writeLock;
+        if (!prepared.readOnly)
+            writeLock = std::unique_lock<writerMutex>(*writer);
+        auto ret = SQLResult::query(prepared, params);
+        statements.release(SQL, std::move(prepared));
+        return ret;
+    }
+
+    //Takes a statement from the cache, or prepares a new one, the statement is null if the SQL could not be parsed
+    preparedStatement prepare(std::string_view SQL)
+    {
+        preparedStatement ret = statements.acquire(SQL);
+        if (ret.statement == nullptr)
+        {
+            assert(SQL.size() <= std::numeric_limits<int>::max());
+            statementReads reads;
+            if (results != nullptr)
+                collecting = &reads;
+            sqlite3_prepare_v2(database, SQL.data(), static_cast<int>(SQL.size()), &ret.statement, nullptr);
+            collecting = nullptr;
+            if (ret.statement == nullptr)
+                return ret;
+            ret.readOnly = sqlite3_stmt_readonly(ret.statement) != 0;
+            if (results != nullptr && ret.readOnly && reads.deterministic)
+                ret.cacheable = results->resolve(reads.tables, ret.dependencies);
+
+            if (planAuditRows >= 0)
+                reportScans(SQL, planAuditRows);
+
+            const int count = sqlite3_bind_parameter_count(ret.statement);
+            ret.parameterNames.reserve(count);
+            for (int i = 1; i <= count; i++)
+            {
+                const char* name = sqlite3_bind_parameter_name(ret.statement, i);
+                ret.parameterNames.emplace_back(name == nullptr ? "" : name);
+            }
+        }
+        return ret;
+    }
 public:
 
     using callbackFunction = int(*)(void*, int, char**, char**);
 
+    //Enough for every route's fixed SQL, the remainder (generated update statements) churns through the tail
+    static constexpr size_t defaultStatementCacheSize = 128;
+    //The connection is shared between threads, so SQLite must serialize access to it regardless of how it was built
+    static constexpr int openFlags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_URI | SQLITE_OPEN_FULLMUTEX;
+    static constexpr int readOnlyFlags = SQLITE_OPEN_READONLY | SQLITE_OPEN_URI | SQLITE_OPEN_FULLMUTEX;
+    //Milliseconds to wait for another connection's lock
+    static constexpr int busyTimeout = 5000;
+
     sqlite3DB() = delete;
     //RAM-Database overload
     sqlite3DB(std::nullptr_t)
     {
-        int result = sqlite3_open(nullptr, &database);
+        int result = sqlite3_open_v2(nullptr, &database, openFlags, nullptr);
         if (result != SQLITE_OK)
         {
             database = nullptr;
         }
     }
-    sqlite3DB(std::string_view source)
+    //Opens a file (or URI), read-only connections are used to read alongside a separate writer
+    sqlite3DB(std::string_view source, bool readOnly = false)
     {
-        int result = sqlite3_open(source.data(), &database);
+        int result = sqlite3_open_v2(source.data(), &database, readOnly ? readOnlyFlags : openFlags, nullptr);
         if (result != SQLITE_OK)
         {
+            sqlite3_close(database);
             database = nullptr;
+            return;
         }
+        //Connections sharing a database wait for each other's locks rather than failing
+        sqlite3_busy_timeout(database, busyTimeout);
     }
 
     sqlite3DB(const sqlite3DB&) = delete;
@@ -162,12 +1292,22 @@ public:
     {
         database = move.database;
         move.database = nullptr;
+        statements = std::move(move.statements);
+        std::swap(writer, move.writer);
+        planAuditRows = move.planAuditRows;
+        std::swap(tracked, move.tracked);
+        std::swap(results, move.results);
     }
 
     sqlite3DB& operator=(const sqlite3DB&) = delete;
     sqlite3DB& operator=(sqlite3DB&& move) noexcept
     {
         std::swap(database, move.database);
+        std::swap(statements, move.statements);
+        std::swap(writer, move.writer);
+        std::swap(planAuditRows, move.planAuditRows);
+        std::swap(tracked, move.tracked);
+        std::swap(results, move.results);
         return *this;
     }
 
@@ -175,6 +1315,8 @@ public:
     {
         if (database != nullptr)
         {
+            //Any outstanding statements would prevent the database from closing
+            statements.clear();
             sqlite3_close(database);
         }
     }
@@ -184,9 +1326,314 @@ public:
         return database != nullptr;
     }
 
-    std::pair<SQLCode, SQLResult> query(std::string_view SQL, const std::unordered_map<std::string_view, std::string_view>& namedParams)
+    std::pair<SQLCode, SQLResult> query(std::string_view SQL, const SQLParams& params)
+    {
+        preparedStatement prepared = prepare(SQL);
+        if (prepared.statement == nullptr)
+        {
+            return { SQLITE_ERROR, SQLResult::empty() };
+        }
+        return execute(SQL, std::move(prepared), params);
+    }
+
+    //As query, but a read is answered from the result cache for as long as none of the tables it reads have changed
+    //Without a result cache, or for a statement which writes or reads anything untracked, this is exactly query
+    std::pair<SQLCode, SQLResult> cachedQuery(std::string_view SQL, const SQLParams& params)
+    {
+        if (results == nullptr || !params.valid())
+            return query(SQL, params);
+
+        preparedStatement prepared = prepare(SQL);
+        if (prepared.statement == nullptr)
+        {
+            return { SQLITE_ERROR, SQLResult::empty() };
+        }
+        if (!prepared.cacheable)
+            return execute(SQL, std::move(prepared), params);
+
+        std::string key = queryResultCache::key(SQL, params);
+        if (auto hit = results->find(key); hit.has_value())
+        {
+            statements.release(SQL, std::move(prepared));
+            return { SQLITE_OK, std::move(hit.value()) };
+        }
+
+        auto dependencies = results->stamp(prepared.dependencies);
+        auto ret = execute(SQL, std::move(prepared), params);
+        if (ret.first)
+            results->store(std::move(key), ret.second, std::move(dependencies));
+        return ret;
+    }
+
+    //Binds a query without running it, rows are then produced one at a time as the cursor is stepped
+    SQLCursor cursor(std::string_view SQL, const SQLParams& params)
+    {
+        preparedStatement prepared = prepare(SQL);
+        if (prepared.statement == nullptr)
+        {
+            return SQLCursor(SQLITE_ERROR);
+        }
+
+        std::unique_lock<writerMutex> writeLock;
+        if (!prepared.readOnly)
+            writeLock = std::unique_lock<writerMutex>(*writer);
+        const SQLCode bound = prepared.bind(params);
+        SQLCursor ret(std::move(prepared), statements, SQL, std::move(writeLock));
+        if (!bound)
+        {
+            return SQLCursor(bound.errorCode);
+        }
+        return ret;
+    }
+
+    statementCache::statistics statementStatistics() const
+    {
+        return statements.getStatistics();
+    }
+
+    //A table a statement reads in full rather than through an index
+    struct tableScan
+    {
+        std::string table;
+        //Estimated from the largest row ID, so counts rows since deleted
+        int64_t rows = 0;
+        //The step of the query plan, as reported by SQLite
+        std::string detail;
+    };
+
+    //Runs EXPLAIN QUERY PLAN over a statement and lists the tables of at least minRows rows it scans
+    //Bypasses the statement cache, the statement is not run
+    std::pair<SQLCode, std::vector<tableScan>> fullScans(std::string_view SQL, int64_t minRows = 0)
+    {
+        const std::string explain = "EXPLAIN QUERY PLAN " + std::string(SQL);
+        sqlite3_stmt* plan = nullptr;
+        SQLCode status = sqlite3_prepare_v2(database, explain.c_str(), static_cast<int>(explain.size()), &plan, nullptr);
+        if (!status)
+            return { status, {} };
+
+        const auto aliases = tableAliases(SQL);
+        std::vector<tableScan> ret;
+        int result;
+        while ((result = sqlite3_step(plan)) == SQLITE_ROW)
+        {
+            const char* text = reinterpret_cast<const char*>(sqlite3_column_text(plan, 3));
+            const std::string_view detail = text == nullptr ? std::string_view() : text;
+            //"SCAN <name>" (or "SCAN TABLE <name>" before SQLite 3.36), optionally followed by the index it walks, subqueries and constant rows are not tables
+            if (detail.substr(0, 5) != "SCAN ")
+                continue;
+            std::string_view scanned = detail.substr(5);
+            if (scanned.substr(0, 6) == "TABLE ")
+                scanned.remove_prefix(6);
+            if (scanned.empty() || scanned[0] == '(' || scanned.substr(0, 9) == "SUBQUERY " || scanned == "CONSTANT ROW")
+                continue;
+            //Virtual tables (full text indexes) are always "scanned", they only read everything when given no constraints to use
+            if (const size_t index = detail.find(" VIRTUAL TABLE INDEX "); index != std::string_view::npos && detail.back() != ':')
+                continue;
+            std::string name(scanned.substr(0, scanned.find(' ')));
+            if (const auto it = aliases.find(name); it != aliases.end())
+                name = it->second;
+
+            tableScan scan{ name, 0, std::string(detail) };
+            //Every table has a row ID, so its maximum is found without a scan of its own
+            sqlite3_stmt* count = nullptr;
+            const std::string countSQL = "SELECT MAX(ROWID) FROM \"" + name + "\"";
+            if (sqlite3_prepare_v2(database, countSQL.c_str(), static_cast<int>(countSQL.size()), &count, nullptr) == SQLITE_OK && sqlite3_step(count) == SQLITE_ROW)
+                scan.rows = sqlite3_column_int64(count, 0);
+            sqlite3_finalize(count);
+
+            if (scan.rows >= minRows)
+                ret.push_back(std::move(scan));
+        }
+        sqlite3_finalize(plan);
+        if (result != SQLITE_DONE)
+            return { result, {} };
+        return { SQLITE_OK, std::move(ret) };
+    }
+
+    //Prints any full scans of tables with at least minRows rows a statement makes
+    void reportScans(std::string_view SQL, int64_t minRows)
+    {
+        const auto [status, scans] = fullScans(SQL, minRows);
+        if (!status || scans.empty())
+            return;
+        std::string report = "Query plan audit: \"" + std::string(SQL) + "\"\n";
+        for (const auto& i : scans)
+        {
+            report += "    scans " + i.table + " (~" + std::to_string(i.rows) + " rows): " + i.detail + "\n";
+        }
+        //Written in one piece so reports from different threads do not interleave
+        std::cout << report;
+    }
+
+    //Checks every statement as it is first prepared, reporting full scans of tables with at least minRows rows, negative disables
+    //Statements already cached are not checked again
+    void auditPlans(int64_t minRows)
+    {
+        planAuditRows = minRows;
+    }
+
+    //Keeps a generation for each of the tables, moved on whenever a write to the table through this connection finishes
+    //Only sees writes made through this connection, so must be called on the (single) writer, replaces any tables tracked before
+    void trackTables(const std::vector<std::string>& tables)
+    {
+        if (database == nullptr)
+            return;
+        //A result cache belongs to the tables it was created with, so goes with them
+        if (results != nullptr)
+            useResultCache(nullptr);
+        auto replacement = std::make_shared<tableGenerations>(tables);
+        std::lock_guard<writerMutex> writeLock(*writer);
+        replacement->attach(database);
+        writer->track(database, replacement.get());
+        tracked = std::move(replacement);
+    }
+
+    //The current generation of a table, by its position in the tracked tables, 0 if it is not tracked
+    uint64_t generation(size_t table) const
+    {
+        return tracked == nullptr ? 0 : tracked->get(table);
+    }
+
+    //The current generation of every tracked table, empty if none are tracked
+    generationSnapshot generations() const
+    {
+        return tracked == nullptr ? generationSnapshot() : tracked->snapshot();
+    }
+
+    //Keeps up to maxBytes of the results of reads made through cachedQuery, the tables must be tracked first (trackTables)
+    //0 disables the cache
+    void enableResultCache(size_t maxBytes)
+    {
+        useResultCache(tracked == nullptr || maxBytes == 0 ? nullptr : std::make_shared<queryResultCache>(tracked, maxBytes));
+    }
+
+    //Shares another connection's result cache (such as the writer's with a reader), null stops caching results
+    //Must be called before the connection is used by other threads
+    void useResultCache(std::shared_ptr<queryResultCache> cache)
+    {
+        if (database == nullptr)
+            return;
+        results = std::move(cache);
+        //The tables a statement reads are only found as it is prepared, so statements prepared until now cannot be cached
+        statements.clear();
+        sqlite3_set_authorizer(database, results == nullptr ? nullptr : collectReads, nullptr);
+    }
+
+    std::shared_ptr<queryResultCache> resultCache() const
+    {
+        return results;
+    }
+
+    //Begins a transaction, or a savepoint if one is already running, check the result before relying on it
+    SQLTransaction transaction()
+    {
+        return SQLTransaction(database, *writer);
+    }
+
+    //Switches a file-backed database to write-ahead logging and applies the storage options
+    //Commits then only sync the log (synchronous=NORMAL), which is durable against crashes of the process but may lose the last commits on power loss
+    SQLCode configure(const databaseSettings& settings)
+    {
+        if (!settings.isFileBacked())
+        {
+            liftSizeLimit();
+            return SQLITE_OK;
+        }
+
+        const auto [journalStatus, journal] = query("PRAGMA journal_mode=WAL", {});
+        if (!journalStatus)
+            return journalStatus;
+        if (journal.rowCount() != 1 || journal[0][0] != "wal")
+            return SQLITE_ERROR;
+
+        //Pragma values cannot be bound, but every value here is numeric
+        std::string pragmas = "PRAGMA synchronous=NORMAL;";
+        pragmas += "PRAGMA mmap_size=" + std::to_string(settings.mmapSize) + ";";
+        pragmas += "PRAGMA cache_size=" + std::to_string(settings.cacheSize) + ";";
+        pragmas += "PRAGMA temp_store=" + std::to_string(settings.tempStore) + ";";
+        //Checkpoints are left to the background scheduler so that commits never have to wait for one
+        if (settings.checkpointInterval.count() > 0)
+            pragmas += "PRAGMA wal_autocheckpoint=0;";
+
+        return sqlite3_exec(database, pragmas.c_str(), nullptr, nullptr, nullptr);
+    }
+
+    //Writes an image of the whole database to a file, replacing any previous image only once the new one is complete
+    //Writes are held off while the image is copied
+    SQLCode snapshot(const std::string& file)
+    {
+        sqlite3_int64 size = 0;
+        unsigned char* image = nullptr;
+        {
+            std::lock_guard<writerMutex> writeLock(*writer);
+            //An image taken mid-transaction (by the thread holding it) would contain half of it, so wait for the next attempt
+            if (sqlite3_get_autocommit(database) == 0)
+                return SQLITE_BUSY;
+            image = sqlite3_serialize(database, "main", &size, 0);
+        }
+        if (image == nullptr)
+            return SQLITE_NOMEM;
+
+        const std::string temporary = file + ".tmp";
+        bool written;
+        {
+            std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+            written = out && out.write(reinterpret_cast<const char*>(image), size) && out.flush();
+        }
+        sqlite3_free(image);
+
+        std::error_code error;
+        if (written)
+            std::filesystem::rename(temporary, file, error);
+        if (!written || error)
+        {
+            std::filesystem::remove(temporary, error);
+            return SQLITE_IOERR;
+        }
+        return SQLITE_OK;
+    }
+
+    //Replaces the contents of the in-memory database with an image written by snapshot()
+    //The image is read with a single read into memory SQLite then takes over as the database itself, so it is only ever held once
+    SQLCode restore(const std::string& file)
+    {
+        std::ifstream in(file, std::ios::binary | std::ios::ate);
+        if (!in)
+            return SQLITE_CANTOPEN;
+        const sqlite3_int64 size = in.tellg();
+        if (size <= 0)
+            return SQLITE_CORRUPT;
+
+        unsigned char* image = static_cast<unsigned char*>(sqlite3_malloc64(size));
+        if (image == nullptr)
+            return SQLITE_NOMEM;
+        in.seekg(0);
+        if (!in.read(reinterpret_cast<char*>(image), size))
+        {
+            sqlite3_free(image);
+            return SQLITE_IOERR;
+        }
+
+        std::lock_guard<writerMutex> writeLock(*writer);
+        //Statements prepared against the old contents are discarded, the database cannot be replaced while any is in use
+        statements.clear();
+        //SQLite takes ownership of the image, freeing it when done (even if this fails)
+        const SQLCode result = sqlite3_deserialize(database, "main", image, size, size, SQLITE_DESERIALIZE_FREEONCLOSE | SQLITE_DESERIALIZE_RESIZEABLE);
+        if (result)
+        {
+            //The replacement starts out with SQLite's default maximum size again
+            liftSizeLimit();
+            //The image replaces pages rather than rows, so is not seen by the update hook
+            if (tracked != nullptr)
+                tracked->changedAll();
+        }
+        return result;
+    }
+
+    //Copies as much of the write-ahead log back into the database as possible without blocking readers or writers
+    SQLCode checkpoint()
     {
-        return SQLResult::query(database, SQL, namedParams);
+        return sqlite3_wal_checkpoint_v2(database, nullptr, SQLITE_CHECKPOINT_PASSIVE, nullptr, nullptr);
     }
 };
 
@@ -194,5 +1641,10 @@ class body;
 
 //Simple function to wrap the input in %%'s, useful for some SQL queries
 std::string generateLIKEArgument(std::string_view val);
+//Whether a search term is long enough (three characters) to be found through a trigram full text index
+//Shorter terms must fall back to LIKE, as the index holds nothing shorter
+bool isTrigramSearchable(std::string_view val);
+//Quotes the input as a single FTS5 phrase, so it is matched as a substring rather than read as a query
+std::string generateMATCHArgument(std::string_view val);
 //Function to modify the inputs in order to create an SQL statement that LIKE matches all inputs
 std::string generateUpdateStatement(const body& b, const std::unordered_map<std::string, std::string>& relations);
@@ -0,0 +1,231 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <algorithm>
+#include <optional>
+#include <iostream>
+#include "uwebsockets/App.h"
+#include "Network.h"
+
+//The outcome of a route's database work, written to its response back on the network loop
+struct routeResult
+{
+    const char* status = HTTPCodes::OK;
+    std::string body;
+    //Sent as the response's ETag when not empty
+    std::string etag;
+};
+
+//Passed to streamed work, sends each chunk of the response to the client as soon as it is ready
+class routeStream final
+{
+    uWS::HttpResponse<true>* res;
+    uWS::Loop* loop;
+    std::shared_ptr<bool> aborted;
+    bool sent = false;
+
+public:
+    routeStream(uWS::HttpResponse<true>* response, uWS::Loop* responseLoop, std::shared_ptr<bool> abortFlag) : res(response), loop(responseLoop), aborted(std::move(abortFlag)) {}
+
+    void write(std::string chunk)
+    {
+        sent = true;
+        loop->defer([res = res, aborted = aborted, chunk = std::move(chunk)]()
+            {
+                if (*aborted)
+                    return;
+                res->cork([&]()
+                    {
+                        res->write(chunk);
+                    });
+            });
+    }
+
+    //Once anything has been sent the status can no longer change
+    bool hasSent() const
+    {
+        return sent;
+    }
+};
+
+//Runs routes' database reads on a pool of threads so a slow query never holds up the network loop, or the other reads
+//With a file-backed database each thread reads through its own read-only connection, so reads run in parallel (through the write-ahead log) while writes stay on the writer connection in order
+//An in-memory database has no write-ahead log, so a reader's lock would hold the writer, and with it the network loop, until the read finished; its threads read through the writer instead
+//The request itself does not outlive its handler, so handlers check it (arguments, sessions) on the loop and only submit the remainder
+class dbExecutor final
+{
+public:
+    //Runs on a database thread, it must copy anything it needs from the request
+    using work = std::function<routeResult(sqlite3DB& reader)>;
+    //As work, but may send parts of its response early
+    using streamedWork = std::function<routeResult(sqlite3DB& reader, routeStream& stream)>;
+
+private:
+    std::mutex lock;
+    std::condition_variable wake;
+    struct queuedTask
+    {
+        //Runs the work on a database thread, then answers the request on the loop
+        std::function<void(sqlite3DB&)> run;
+        //Answers the request with an error instead, should the executor stop before the work runs
+        std::function<void()> abandon;
+    };
+    std::deque<queuedTask> tasks;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+
+    void run(sqlite3DB& writer, const std::string& readerSource, int64_t planAuditRows)
+    {
+        std::optional<sqlite3DB> ownReader;
+        if (!readerSource.empty())
+        {
+            ownReader.emplace(readerSource, true);
+            ownReader->auditPlans(planAuditRows);
+            //Results read on any thread answer the same query on every other
+            ownReader->useResultCache(writer.resultCache());
+        }
+        //Without a reader of its own the thread reads through the writer
+        sqlite3DB& reader = ownReader.has_value() && ownReader->isOpen() ? *ownReader : writer;
+
+        while (true)
+        {
+            queuedTask task;
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                wake.wait(guard, [this]() { return stopping || !tasks.empty(); });
+                //Work still queued once the network has stopped is abandoned by the destructor
+                if (stopping)
+                    return;
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task.run(reader);
+        }
+    }
+
+    void enqueue(uWS::HttpResponse<true>* res, streamedWork apply)
+    {
+        //Only ever read or written on the loop, so needs no further synchronisation
+        auto aborted = std::make_shared<bool>(false);
+        res->onAborted([aborted]()
+            {
+                *aborted = true;
+            });
+
+        uWS::Loop* loop = uWS::Loop::get();
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            tasks.push_back({ [res, loop, aborted, apply = std::move(apply)](sqlite3DB& reader)
+                {
+                    routeStream stream(res, loop, aborted);
+                    auto result = std::make_shared<routeResult>();
+                    //An exception leaving the thread would end the whole server, so it only fails this request
+                    try
+                    {
+                        *result = apply(reader, stream);
+                    }
+                    catch (const std::exception& e)
+                    {
+                        std::cout << "Database work failed: " << e.what() << "\n";
+                        result->status = HTTPCodes::INTERNALERROR;
+                    }
+                    catch (...)
+                    {
+                        std::cout << "Database work failed.\n";
+                        result->status = HTTPCodes::INTERNALERROR;
+                    }
+                    const bool sent = stream.hasSent();
+                    //Deferred functions run in order, so this follows any chunks already sent
+                    loop->defer([res, aborted, result, sent]()
+                        {
+                            if (*aborted)
+                                return;
+                            //Responses are written from outside of their request handlers, so must be corked
+                            res->cork([&]()
+                                {
+                                    //A failure part way through a response can only be reported by dropping the connection
+                                    if (sent && std::string_view(result->status) != HTTPCodes::OK)
+                                    {
+                                        res->close();
+                                        return;
+                                    }
+                                    if (!sent)
+                                    {
+                                        res->writeStatus(result->status);
+                                        if (!result->etag.empty())
+                                            res->writeHeader("ETag", result->etag);
+                                    }
+                                    res->end(result->body);
+                                });
+                        });
+                }, [res, aborted]()
+                {
+                    if (*aborted)
+                        return;
+                    res->cork([&]()
+                        {
+                            res->writeStatus(HTTPCodes::INTERNALERROR);
+                            res->end();
+                        });
+                } });
+        }
+        wake.notify_one();
+    }
+
+public:
+    //A file-backed database is opened read-only by each thread, it must be the writer's file
+    dbExecutor(sqlite3DB& writer, const databaseSettings& settings)
+    {
+        const size_t threads = std::max<size_t>(settings.executorThreads, 1);
+        for (size_t i = 0; i < threads; i++)
+        {
+            workers.emplace_back([this, &writer, readerSource = settings.isFileBacked() ? settings.file : std::string(), planAuditRows = settings.planAuditRows]()
+                {
+                    run(writer, readerSource, planAuditRows);
+                });
+        }
+    }
+
+    //The workers refer back to this object, so it cannot be copied or moved
+    dbExecutor(const dbExecutor&) = delete;
+    dbExecutor& operator=(const dbExecutor&) = delete;
+
+    ~dbExecutor()
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& i : workers)
+        {
+            i.join();
+        }
+        //The executor is destroyed on the loop's thread, so the requests still queued can be answered directly
+        for (auto& i : tasks)
+        {
+            i.abandon();
+        }
+    }
+
+    //Runs the work on a database thread, then answers the request with its result on the calling thread's loop
+    //If the client disconnects in the meantime the result is dropped, takes over the response's abort handler
+    void submit(uWS::HttpResponse<true>* res, work apply)
+    {
+        enqueue(res, [apply = std::move(apply)](sqlite3DB& reader, routeStream&)
+            {
+                return apply(reader);
+            });
+    }
+
+    //As submit, but the work may send its response in chunks as it is produced
+    void stream(uWS::HttpResponse<true>* res, streamedWork apply)
+    {
+        enqueue(res, std::move(apply));
+    }
+};
@@ -16,6 +16,7 @@ namespace HTTPCodes
 {
     constexpr auto OK                   = "200";
     constexpr auto NOCONTENT_NOREDIRECT = "204"; //Note that a browser recieving code 204 may choose to not redirect from the page, prefer 404 instead (as appropriate)
+    constexpr auto NOTMODIFIED          = "304";
     constexpr auto BADREQUEST           = "400";
     constexpr auto UNAUTHORISED         = "401";
     constexpr auto FORBIDDEN            = "403";
@@ -24,6 +25,185 @@ namespace HTTPCodes
     constexpr auto INTERNALERROR        = "500";
 }
 
+//Streamed responses are written to the socket whenever roughly this much text has been serialized
+constexpr size_t streamChunkSize = 16 * 1024;
+
+//Keyset pagination for the search routes, a page holds at most "limit" rows following the "after" cursor
+//Each page's response gives the cursor of its final row as "next", which is left empty once no rows follow
+class pageRequest
+{
+    int64_t limit = defaultLimit;
+    //The "next" value of the previous page, empty for the first page
+    std::string after;
+
+public:
+    static constexpr int64_t defaultLimit = 50;
+    static constexpr int64_t maxLimit = 500;
+
+    //Nothing if the limit is not a whole number from 1 to maxLimit
+    static std::optional<pageRequest> fromQuery(const query& q)
+    {
+        pageRequest ret;
+        if (q.hasElement("limit"))
+        {
+            const auto& val = q.getElement("limit");
+            const auto result = std::from_chars(val.data(), val.data() + val.size(), ret.limit);
+            if (result.ec != std::errc() || result.ptr != val.data() + val.size() || ret.limit < 1 || ret.limit > maxLimit)
+                return {};
+        }
+        if (q.hasElement("after"))
+            ret.after = q.getElement("after");
+        return ret;
+    }
+
+    int64_t getLimit() const { return limit; }
+    bool isFirst() const { return after.empty(); }
+    //Searches read one row past the limit, to tell whether another page follows
+    int64_t readLimit() const { return limit + 1; }
+
+    //The first ID a page of rows ordered by ID may hold
+    std::optional<int64_t> afterID() const
+    {
+        if (isFirst())
+            return std::numeric_limits<int64_t>::min();
+        int64_t ID;
+        const auto result = std::from_chars(after.data(), after.data() + after.size(), ID);
+        if (result.ec != std::errc() || result.ptr != after.data() + after.size() || ID == std::numeric_limits<int64_t>::max())
+            return {};
+        return ID + 1;
+    }
+
+    //Cursors of searches ordered by full text rank, with ties broken by ID, take the form "rank_ID"
+    //The rank is written so it reads back exactly, so no row is skipped or repeated at the edge of a page
+    static std::string rankCursor(double rank, int64_t ID)
+    {
+        char buffer[64];
+        const auto result = std::to_chars(buffer, buffer + sizeof(buffer), rank);
+        return std::string(buffer, result.ptr) + "_" + std::to_string(ID);
+    }
+
+    //The rank and ID of a ranked cursor, nothing if the cursor is not of that form (including for the first page)
+    std::optional<std::pair<double, int64_t>> afterRank() const
+    {
+        const size_t div = after.find('_');
+        if (div == std::string::npos)
+            return {};
+        double rank;
+        int64_t ID;
+        const auto rankResult = std::from_chars(after.data(), after.data() + div, rank);
+        const auto IDResult = std::from_chars(after.data() + div + 1, after.data() + after.size(), ID);
+        if (rankResult.ec != std::errc() || rankResult.ptr != after.data() + div || IDResult.ec != std::errc() || IDResult.ptr != after.data() + after.size())
+            return {};
+        return std::make_pair(rank, ID);
+    }
+
+    //Appends the conditions, ordering and limit selecting this page to a search, which must already have a WHERE clause
+    //Ranked searches are ordered by the rank of the full text index aliased F and then by the key (an ID), others by the key alone
+    //Fails if the cursor could not have come from the same search
+    bool apply(std::string& SQL, SQLParams& params, std::string_view key, bool ranked) const
+    {
+        if (ranked)
+        {
+            if (!isFirst())
+            {
+                const auto cursor = afterRank();
+                if (!cursor.has_value())
+                    return false;
+
+                SQL += " AND (F.RANK, " + std::string(key) + ") > (:RNK, :AFT)";
+                params.add({ ":RNK", cursor->first });
+                params.add({ ":AFT", cursor->second });
+            }
+            SQL += " ORDER BY F.RANK, " + std::string(key);
+        }
+        else
+        {
+            if (!isFirst())
+            {
+                //Bound as text, which an integer key's affinity turns back into a number
+                SQL += " AND " + std::string(key) + " > :AFT";
+                params.add({ ":AFT", after });
+            }
+            SQL += " ORDER BY " + std::string(key);
+        }
+        SQL += " LIMIT :LIM";
+        params.add({ ":LIM", readLimit() });
+        return true;
+    }
+};
+
+//Entity tags (ETags) for responses read from the database, built from the generations of the tables read and the request's arguments
+//A committed write to any of the tables gives every response read from them a new tag, so a client's copy is only confirmed while still current
+class entityTag
+{
+    std::string tag;
+
+    //64-bit FNV-1a
+    static void mix(uint64_t& hash, std::string_view bytes)
+    {
+        for (const char i : bytes)
+        {
+            hash ^= static_cast<unsigned char>(i);
+            hash *= 1099511628211ull;
+        }
+    }
+
+    static void mix(uint64_t& hash, uint64_t value)
+    {
+        mix(hash, std::string_view(reinterpret_cast<const char*>(&value), sizeof(value)));
+    }
+
+public:
+    //Must be made before the response is read, a write landing in between then only leaves the tag out of date (costing a refetch) rather than wrong
+    //The scope separates responses which differ for the same arguments, such as those limited to the session's own user
+    entityTag(std::string_view route, std::string_view arguments, std::initializer_list<serverData::tables> tables, std::string_view scope = {})
+    {
+        //Generations start again with each run of the server, so a tag from a previous run must not match
+        static const uint64_t epoch = (static_cast<uint64_t>(std::random_device{}()) << 32) ^ std::random_device{}();
+
+        uint64_t hash = 14695981039346656037ull;
+        mix(hash, epoch);
+        mix(hash, route);
+        mix(hash, std::string_view("\0", 1));
+        mix(hash, arguments);
+        mix(hash, std::string_view("\0", 1));
+        mix(hash, scope);
+        for (const auto i : tables)
+        {
+            mix(hash, static_cast<uint64_t>(i));
+            mix(hash, serverData::database->generation(i));
+        }
+
+        char buffer[16];
+        const auto end = std::to_chars(std::begin(buffer), std::end(buffer), hash, 16).ptr;
+        tag = "\"" + std::string(buffer, end) + "\"";
+    }
+
+    const std::string& value() const
+    {
+        return tag;
+    }
+
+    //Whether the request's If-None-Match header lists this tag, or is "*"
+    bool matches(uWS::HttpRequest* req) const
+    {
+        const std::string_view header = req->getHeader("if-none-match");
+        //The quotes delimit each tag in the list, so no other tag can contain this one
+        return header == "*" || header.find(tag) != std::string_view::npos;
+    }
+
+    //Answers with Not Modified if the client already holds the current response, returns whether it did
+    bool answer(uWS::HttpResponse<true>* res, uWS::HttpRequest* req) const
+    {
+        if (!matches(req))
+            return false;
+        res->writeStatus(HTTPCodes::NOTMODIFIED);
+        res->writeHeader("ETag", tag);
+        res->end();
+        return true;
+    }
+};
+
 //Simplifies the extraction of HTTP data (query, body, etc.) and executes it on a function pointer
 class HttpCallWrapper
 {
@@ -243,16 +423,12 @@ public:
 
         session ses;
         {
-            auto convres = std::from_chars(matches[0][0].data(), matches[0][0].data() + matches[0][0].size(), ses.userID);
-            if (convres.ec != std::errc())
+            const auto userID = matches.getInteger(0, 0);
+            const auto permissions = matches.getInteger(0, 1);
+            if (!userID.has_value() || !permissions.has_value())
                 return false;
-        }
-        {
-            unsigned int temp;
-            auto convres = std::from_chars(matches[0][1].data(), matches[0][1].data() + matches[0][1].size(), temp);
-            if (convres.ec != std::errc())
-                return false;
-            ses.authLevel = static_cast<authLevel>(temp);
+            ses.userID = userID.value();
+            ses.authLevel = static_cast<authLevel>(permissions.value());
         }
 
         sessions[val] = std::move(ses);
@@ -311,6 +487,11 @@ public:
             return false;
         return std::to_string(ID.value()) == UID;
     }
+    bool isSessionUser(uWS::HttpRequest* req, std::optional<int64_t> UID) const
+    {
+        const auto ID = getSessionUser(req);
+        return ID.has_value() && UID.has_value() && static_cast<int64_t>(ID.value()) == UID.value();
+    }
     bool isSessionUserFromID(uWS::HttpRequest* req, std::string_view userIndex) const
     {
         const auto ID = getSessionUser(req);
@@ -324,4 +505,5 @@ public:
     }
 };
 
-void net();
\ No newline at end of file
+//Runs the web server until it is stopped
+void net(const databaseSettings& settings);
\ No newline at end of file
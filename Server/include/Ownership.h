@@ -0,0 +1,98 @@
+#pragma once
+#include <unordered_map>
+#include <optional>
+#include <charconv>
+#include <string_view>
+#include "Database.h"
+#include "ServerData.h"
+
+//Who owns each vehicle, and which vehicle each service is for, held in memory so permission checks need not read the database
+//Loaded once the console has finished with the database, then kept in step by the routes which create and delete vehicles and services
+//Must be created and used on the thread running the network loop
+class ownershipIndex final
+{
+    std::unordered_map<int64_t, int64_t> vehicleOwners;
+    std::unordered_map<int64_t, int64_t> serviceVehicles;
+
+    static std::optional<int64_t> parseID(std::string_view text)
+    {
+        int64_t ID;
+        const auto result = std::from_chars(text.data(), text.data() + text.size(), ID);
+        if (result.ec != std::errc() || result.ptr != text.data() + text.size())
+            return {};
+        return ID;
+    }
+
+public:
+    //Replaces the index with the database's current vehicles and services, returning false (leaving the index empty) if either could not be read
+    bool load(sqlite3DB& DB)
+    {
+        vehicleOwners.clear();
+        serviceVehicles.clear();
+
+        const auto [vStatus, vResult] = DB.query("SELECT ID, OWNER FROM " + serverData::tableNames[serverData::VEHICLES], {});
+        const auto [sStatus, sResult] = DB.query("SELECT ID, VEHICLE FROM " + serverData::tableNames[serverData::SERVICES], {});
+        if (!vStatus || !sStatus)
+            return false;
+
+        vehicleOwners.reserve(vResult.rowCount());
+        for (size_t i = 0; i < vResult.rowCount(); i++)
+        {
+            const auto ID = vResult.getInteger(i, 0);
+            const auto owner = vResult.getInteger(i, 1);
+            if (ID.has_value() && owner.has_value())
+                vehicleOwners[ID.value()] = owner.value();
+        }
+        serviceVehicles.reserve(sResult.rowCount());
+        for (size_t i = 0; i < sResult.rowCount(); i++)
+        {
+            const auto ID = sResult.getInteger(i, 0);
+            const auto vehicle = sResult.getInteger(i, 1);
+            if (ID.has_value() && vehicle.has_value())
+                serviceVehicles[ID.value()] = vehicle.value();
+        }
+        return true;
+    }
+
+    //Empty if there is no such vehicle
+    std::optional<int64_t> vehicleOwner(int64_t vehicle) const
+    {
+        const auto it = vehicleOwners.find(vehicle);
+        if (it == vehicleOwners.end())
+            return {};
+        return it->second;
+    }
+    std::optional<int64_t> vehicleOwner(std::string_view vehicle) const
+    {
+        const auto ID = parseID(vehicle);
+        return ID.has_value() ? vehicleOwner(ID.value()) : std::nullopt;
+    }
+
+    //The owner of the service's vehicle, empty if there is no such service or its vehicle has since been deleted
+    std::optional<int64_t> serviceOwner(std::string_view service) const
+    {
+        const auto ID = parseID(service);
+        if (!ID.has_value())
+            return {};
+        const auto it = serviceVehicles.find(ID.value());
+        if (it == serviceVehicles.end())
+            return {};
+        return vehicleOwner(it->second);
+    }
+
+    //Only to be called once the change has reached the database
+    void addVehicle(int64_t vehicle, int64_t owner)
+    {
+        vehicleOwners[vehicle] = owner;
+    }
+    void removeVehicle(std::string_view vehicle)
+    {
+        const auto ID = parseID(vehicle);
+        if (ID.has_value())
+            vehicleOwners.erase(ID.value());
+    }
+    void addService(int64_t service, int64_t vehicle)
+    {
+        serviceVehicles[service] = vehicle;
+    }
+};
@@ -0,0 +1,393 @@
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <charconv>
+#include "Database.h"
+#include "Network.h"
+#include "ServerData.h"
+
+//Every part, with the supplier names and group IDs searches join against, held in memory so part searches and lookups need not read the database
+//Parts are kept as parallel arrays ordered by ID, their names in one shared buffer, so a search walks contiguous memory rather than rows of strings
+//Loaded once the console has finished with the database, then refreshed a row at a time by the part, supplier and group routes
+//Must be created and used on the thread running the network loop
+class partsCatalogue final
+{
+public:
+    //The rows of one page of a search, ordered as they should be returned
+    struct searchResult
+    {
+        //False if the page's cursor could not have come from the same search
+        bool valid = true;
+        std::vector<size_t> rows;
+        //The cursor of the page's final row, empty if no rows follow
+        std::string next;
+    };
+
+private:
+    //One entry per part, at the same index in every array
+    std::vector<int64_t> IDs;
+    std::vector<int64_t> prices;
+    std::vector<int64_t> quantities;
+    std::vector<int64_t> suppliers;
+    std::vector<std::optional<int64_t>> groups;
+    std::vector<size_t> nameStarts;
+    std::vector<size_t> nameLengths;
+
+    //Names as stored, and lower cased (ASCII only, as LIKE does) for matching, both at the same offsets
+    //A renamed part's new name is appended, leaving the old one unused until the buffers are next compacted
+    std::string names;
+    std::string foldedNames;
+    size_t unusedNameBytes = 0;
+
+    //The routes only store whole prices and quantities, but parts written before they checked may hold others
+    //Those parts' prices and quantities are kept here, as the database gives them
+    std::unordered_map<int64_t, std::pair<std::string, std::string>> irregularValues;
+
+    std::unordered_map<int64_t, std::string> supplierNames;
+    std::unordered_set<int64_t> groupIDs;
+    //The IDs of the parts grouped into each, in ascending order
+    std::unordered_map<int64_t, std::vector<int64_t>> byGroup;
+
+    static char fold(char c)
+    {
+        return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+
+    static void insertSorted(std::vector<int64_t>& list, int64_t ID)
+    {
+        const auto it = std::lower_bound(list.begin(), list.end(), ID);
+        if (it == list.end() || *it != ID)
+            list.insert(it, ID);
+    }
+    static void eraseSorted(std::vector<int64_t>& list, int64_t ID)
+    {
+        const auto it = std::lower_bound(list.begin(), list.end(), ID);
+        if (it != list.end() && *it == ID)
+            list.erase(it);
+    }
+
+    std::optional<size_t> rowOf(int64_t ID) const
+    {
+        const auto it = std::lower_bound(IDs.begin(), IDs.end(), ID);
+        if (it == IDs.end() || *it != ID)
+            return {};
+        return static_cast<size_t>(it - IDs.begin());
+    }
+
+    void storeName(size_t row, std::string_view name)
+    {
+        nameStarts[row] = names.size();
+        nameLengths[row] = name.size();
+        names.append(name);
+        for (const char c : name)
+        {
+            foldedNames += fold(c);
+        }
+    }
+
+    //Drops the names no part uses any more, once they make up most of the buffers
+    void compactNames()
+    {
+        if (unusedNameBytes < 4096 || unusedNameBytes < names.size() / 2)
+            return;
+        std::string oldNames;
+        oldNames.swap(names);
+        foldedNames.clear();
+        for (size_t i = 0; i < IDs.size(); i++)
+        {
+            storeName(i, std::string_view(oldNames).substr(nameStarts[i], nameLengths[i]));
+        }
+        unusedNameBytes = 0;
+    }
+
+    void removeRow(size_t row)
+    {
+        if (groups[row].has_value())
+            eraseSorted(byGroup[groups[row].value()], IDs[row]);
+        unusedNameBytes += nameLengths[row];
+        irregularValues.erase(IDs[row]);
+
+        IDs.erase(IDs.begin() + row);
+        prices.erase(prices.begin() + row);
+        quantities.erase(quantities.begin() + row);
+        suppliers.erase(suppliers.begin() + row);
+        groups.erase(groups.begin() + row);
+        nameStarts.erase(nameStarts.begin() + row);
+        nameLengths.erase(nameLengths.begin() + row);
+    }
+
+    //Adds (or replaces) a part from a row of ID, NAME, PRICE, QUANTITY, SUPPLIER, SIMILAR
+    void storePart(const SQLResult& result, size_t i)
+    {
+        const auto ID = result.getInteger(i, 0);
+        if (!ID.has_value())
+            return;
+
+        auto row = rowOf(ID.value());
+        if (row.has_value())
+        {
+            //The index is rebuilt below, as the group may have changed
+            if (groups[row.value()].has_value())
+                eraseSorted(byGroup[groups[row.value()].value()], ID.value());
+            unusedNameBytes += nameLengths[row.value()];
+        }
+        else
+        {
+            //New parts almost always take the highest ID, so are almost always appended
+            row = static_cast<size_t>(std::lower_bound(IDs.begin(), IDs.end(), ID.value()) - IDs.begin());
+            IDs.insert(IDs.begin() + row.value(), ID.value());
+            prices.insert(prices.begin() + row.value(), 0);
+            quantities.insert(quantities.begin() + row.value(), 0);
+            suppliers.insert(suppliers.begin() + row.value(), 0);
+            groups.insert(groups.begin() + row.value(), std::nullopt);
+            nameStarts.insert(nameStarts.begin() + row.value(), 0);
+            nameLengths.insert(nameLengths.begin() + row.value(), 0);
+        }
+
+        const size_t r = row.value();
+        storeName(r, result[i][1]);
+        prices[r] = result.getInteger(i, 2).value_or(0);
+        quantities[r] = result.getInteger(i, 3).value_or(0);
+        if (!result.getInteger(i, 2).has_value() || !result.getInteger(i, 3).has_value())
+            irregularValues[ID.value()] = { std::string(result[i][2]), std::string(result[i][3]) };
+        else
+            irregularValues.erase(ID.value());
+        suppliers[r] = result.getInteger(i, 4).value_or(0);
+        groups[r] = result.getInteger(i, 5);
+
+        if (groups[r].has_value())
+            insertSorted(byGroup[groups[r].value()], ID.value());
+    }
+
+    //Whether a row appears in searches at all, they only return parts whose supplier exists
+    bool isListed(size_t row) const
+    {
+        return supplierNames.count(suppliers[row]) != 0;
+    }
+
+    bool nameContains(size_t row, std::string_view foldedTerm) const
+    {
+        return std::string_view(foldedNames).substr(nameStarts[row], nameLengths[row]).find(foldedTerm) != std::string_view::npos;
+    }
+
+public:
+    //Replaces the catalogue with the database's current parts, suppliers and groups, returning false (leaving it empty) if any could not be read
+    bool load(sqlite3DB& DB)
+    {
+        *this = partsCatalogue();
+
+        const auto [pStatus, pResult] = DB.query("SELECT ID, NAME, PRICE, QUANTITY, SUPPLIER, SIMILAR FROM " + serverData::tableNames[serverData::PARTS] + " ORDER BY ID", {});
+        const auto [sStatus, sResult] = DB.query("SELECT ID, NAME FROM " + serverData::tableNames[serverData::SUPPLIERS], {});
+        const auto [gStatus, gResult] = DB.query("SELECT ID FROM " + serverData::tableNames[serverData::PARTGROUPS], {});
+        if (!pStatus || !sStatus || !gStatus)
+            return false;
+
+        const size_t parts = pResult.rowCount();
+        IDs.reserve(parts);
+        prices.reserve(parts);
+        quantities.reserve(parts);
+        suppliers.reserve(parts);
+        groups.reserve(parts);
+        nameStarts.reserve(parts);
+        nameLengths.reserve(parts);
+        for (size_t i = 0; i < parts; i++)
+        {
+            storePart(pResult, i);
+        }
+        for (size_t i = 0; i < sResult.rowCount(); i++)
+        {
+            const auto ID = sResult.getInteger(i, 0);
+            if (ID.has_value())
+                supplierNames[ID.value()] = sResult[i][1];
+        }
+        for (size_t i = 0; i < gResult.rowCount(); i++)
+        {
+            const auto ID = gResult.getInteger(i, 0);
+            if (ID.has_value())
+                groupIDs.insert(ID.value());
+        }
+        return true;
+    }
+
+    //Re-reads a part once a change to it has reached the database, dropping it if it no longer exists
+    bool refreshPart(sqlite3DB& DB, int64_t ID)
+    {
+        const auto [status, result] = DB.query("SELECT ID, NAME, PRICE, QUANTITY, SUPPLIER, SIMILAR FROM " + serverData::tableNames[serverData::PARTS] + " WHERE ID = :ID", { {":ID", ID} });
+        if (!status)
+            return false;
+        if (result.rowCount() != 0)
+        {
+            storePart(result, 0);
+        }
+        else
+        {
+            const auto row = rowOf(ID);
+            if (row.has_value())
+                removeRow(row.value());
+        }
+        compactNames();
+        return true;
+    }
+
+    //Only to be called once the change has reached the database
+    void setSupplier(int64_t ID, std::string_view name)
+    {
+        supplierNames[ID] = name;
+    }
+    void addGroup(int64_t ID)
+    {
+        groupIDs.insert(ID);
+    }
+
+    size_t size() const { return IDs.size(); }
+    std::optional<size_t> find(int64_t ID) const { return rowOf(ID); }
+
+    int64_t getID(size_t row) const { return IDs[row]; }
+    std::string_view getName(size_t row) const { return std::string_view(names).substr(nameStarts[row], nameLengths[row]); }
+    //Empty if the supplier does not exist
+    std::string_view getSupplierName(size_t row) const
+    {
+        const auto it = supplierNames.find(suppliers[row]);
+        return it == supplierNames.end() ? std::string_view() : std::string_view(it->second);
+    }
+    //Empty if the part is in no group, or its group does not exist
+    std::optional<int64_t> getGroup(size_t row) const
+    {
+        if (!groups[row].has_value() || groupIDs.count(groups[row].value()) == 0)
+            return {};
+        return groups[row];
+    }
+
+    //A part's fields as the part routes return them
+    responseWrapper describe(size_t row) const
+    {
+        const auto group = getGroup(row);
+        const auto irregular = irregularValues.empty() ? irregularValues.end() : irregularValues.find(IDs[row]);
+        responseWrapper ret;
+        ret.add("ID", std::to_string(IDs[row]));
+        ret.add("Name", getName(row));
+        if (irregular != irregularValues.end())
+        {
+            ret.add("Price", irregular->second.first);
+            ret.add("Quantity", irregular->second.second);
+        }
+        else
+        {
+            ret.add("Price", std::to_string(prices[row]));
+            ret.add("Quantity", std::to_string(quantities[row]));
+        }
+        ret.add("Supplier", getSupplierName(row));
+        //As a missing group reads from the database
+        ret.add("GroupID", group.has_value() ? std::to_string(group.value()) : "NULL");
+        return ret;
+    }
+
+    //Finds a page of the parts whose names contain the name given (if any) and which are in the group given (if any)
+    //Names of at least three characters are ranked, shortest (closest) names first and then by ID, as the full text searches are, others are ordered by ID
+    searchResult search(std::optional<std::string_view> name, std::optional<std::string_view> groupText, const pageRequest& page) const
+    {
+        searchResult ret;
+        const bool ranked = name.has_value() && isTrigramSearchable(name.value());
+
+        std::optional<int64_t> group;
+        if (groupText.has_value())
+        {
+            int64_t ID;
+            const auto result = std::from_chars(groupText->data(), groupText->data() + groupText->size(), ID);
+            //No group has an ID which is not a whole number
+            if (result.ec != std::errc() || result.ptr != groupText->data() + groupText->size())
+                return ret;
+            group = ID;
+        }
+
+        std::string term;
+        if (name.has_value())
+        {
+            term.reserve(name->size());
+            for (const char c : name.value())
+            {
+                term += fold(c);
+            }
+        }
+
+        //Parts in a group are found through its index, others by walking every part
+        const std::vector<int64_t>* members = nullptr;
+        if (group.has_value())
+        {
+            const auto it = byGroup.find(group.value());
+            if (groupIDs.count(group.value()) == 0 || it == byGroup.end())
+                return ret;
+            members = &it->second;
+        }
+        const size_t candidates = members != nullptr ? members->size() : IDs.size();
+        //A member the catalogue cannot find is skipped, rather than read as whichever part is in the first row
+        const auto rowAt = [&](size_t i) { return members != nullptr ? rowOf((*members)[i]) : std::optional<size_t>(i); };
+        const auto matches = [&](size_t row) { return isListed(row) && (!name.has_value() || nameContains(row, term)); };
+        const size_t readLimit = static_cast<size_t>(page.readLimit());
+
+        if (!ranked)
+        {
+            const auto after = page.afterID();
+            if (!after.has_value())
+            {
+                ret.valid = false;
+                return ret;
+            }
+            //Candidates are in ID order, so the page starts at the cursor and ends as soon as it is full
+            size_t i = 0;
+            if (members != nullptr)
+                i = static_cast<size_t>(std::lower_bound(members->begin(), members->end(), after.value()) - members->begin());
+            else
+                i = static_cast<size_t>(std::lower_bound(IDs.begin(), IDs.end(), after.value()) - IDs.begin());
+            for (; i < candidates && ret.rows.size() < readLimit; i++)
+            {
+                const auto row = rowAt(i);
+                if (row.has_value() && matches(row.value()))
+                    ret.rows.push_back(row.value());
+            }
+            if (ret.rows.size() > static_cast<size_t>(page.getLimit()))
+            {
+                ret.rows.pop_back();
+                ret.next = std::to_string(IDs[ret.rows.back()]);
+            }
+            return ret;
+        }
+
+        std::optional<std::pair<double, int64_t>> after;
+        if (!page.isFirst())
+        {
+            after = page.afterRank();
+            if (!after.has_value())
+            {
+                ret.valid = false;
+                return ret;
+            }
+        }
+        const auto before = [&](size_t a, size_t b) { return std::make_pair(nameLengths[a], IDs[a]) < std::make_pair(nameLengths[b], IDs[b]); };
+        for (size_t i = 0; i < candidates; i++)
+        {
+            const auto row = rowAt(i);
+            if (!row.has_value())
+                continue;
+            if (after.has_value() && std::make_pair(static_cast<double>(nameLengths[row.value()]), IDs[row.value()]) <= after.value())
+                continue;
+            if (matches(row.value()))
+                ret.rows.push_back(row.value());
+        }
+        //Only the page (and the row showing whether another follows) need be put in order
+        const size_t kept = std::min(ret.rows.size(), readLimit);
+        std::partial_sort(ret.rows.begin(), ret.rows.begin() + kept, ret.rows.end(), before);
+        ret.rows.resize(kept);
+        if (ret.rows.size() > static_cast<size_t>(page.getLimit()))
+        {
+            ret.rows.pop_back();
+            ret.next = pageRequest::rankCursor(static_cast<double>(nameLengths[ret.rows.back()]), IDs[ret.rows.back()]);
+        }
+        return ret;
+    }
+};
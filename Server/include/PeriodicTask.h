@@ -0,0 +1,44 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <functional>
+
+//Runs a function on its own thread at a fixed interval, stopping (without a final run) when destroyed
+class periodicTask final
+{
+    std::mutex lock;
+    std::condition_variable wake;
+    bool stopping = false;
+    std::thread worker;
+
+public:
+    periodicTask(std::chrono::milliseconds interval, std::function<void()> task)
+    {
+        worker = std::thread([this, interval, task = std::move(task)]()
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                while (!wake.wait_for(guard, interval, [this]() { return stopping; }))
+                {
+                    guard.unlock();
+                    task();
+                    guard.lock();
+                }
+            });
+    }
+
+    //The worker refers back to this object, so it cannot be copied or moved
+    periodicTask(const periodicTask&) = delete;
+    periodicTask& operator=(const periodicTask&) = delete;
+
+    ~periodicTask()
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_all();
+        worker.join();
+    }
+};
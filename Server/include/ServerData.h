@@ -4,11 +4,26 @@
 
 class sqlite3DB;
 class authenticator;
+class writeBatcher;
+class dbExecutor;
+class ownershipIndex;
+class vehicleModels;
+class partsCatalogue;
 
 struct serverData
 {
 	static sqlite3DB* database;
 	static authenticator* auth;
+	//Mutating routes queue their writes here so they can be committed together
+	static writeBatcher* writes;
+	//Routes with slow reads run them here rather than on the network loop
+	static dbExecutor* executor;
+	//Answers whether a session owns a vehicle or service without a database read
+	static ownershipIndex* owners;
+	//Every vehicle make and model, by ID and by name
+	static vehicleModels* models;
+	//Every part, answering part searches and lookups from memory
+	static partsCatalogue* catalogue;
 
 	//Each entry matches directly to a value in tableNames, do not change the order of one without changing the order of the other
 	enum tables
@@ -20,11 +35,10 @@ struct serverData
 		PARTSINSERVICE,
 		VEHICLESHARED,
 		VEHICLES,
-		SERVICESHARED,
-		SERVICEUNAUTHORISED,
-		SERVICEACTIVE,
-		SERVICEOPEN,
-		SERVICECLOSED
+		SERVICES,
+		//Full text (trigram) indexes of the tables they are named for, kept in step by triggers
+		SUPPLIERSSEARCH,
+		USERSSEARCH
 	};
 	static const std::vector<std::string> tableNames;
 };
\ No newline at end of file
@@ -0,0 +1,109 @@
+#pragma once
+#include <unordered_map>
+#include <shared_mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include "Database.h"
+#include "ServerData.h"
+
+//Every make and model of vehicle, interned both ways so a vehicle's model is found (or added) without a join
+//Rows of the shared vehicle data are only ever added, so an entry never goes out of date
+//Written on the network loop and read from the database threads
+class vehicleModels final
+{
+public:
+    struct model
+    {
+        std::string make;
+        std::string model;
+    };
+
+private:
+    mutable std::shared_mutex lock;
+    std::unordered_map<std::string, int64_t> IDs;
+    std::unordered_map<int64_t, model> models;
+
+    //Length prefixed, so no make and model can run into another pair
+    static std::string key(std::string_view make, std::string_view model)
+    {
+        std::string ret = std::to_string(make.size());
+        ret += ':';
+        ret.append(make);
+        ret.append(model);
+        return ret;
+    }
+
+    void add(int64_t ID, std::string_view make, std::string_view model)
+    {
+        std::unique_lock<std::shared_mutex> guard(lock);
+        IDs[key(make, model)] = ID;
+        models[ID] = { std::string(make), std::string(model) };
+    }
+
+public:
+    //Replaces the dictionary with the database's current models, returning false (leaving it empty) if they could not be read
+    bool load(sqlite3DB& DB)
+    {
+        const auto [status, result] = DB.query("SELECT ID, MAKE, MODEL FROM " + serverData::tableNames[serverData::VEHICLESHARED], {});
+
+        std::unique_lock<std::shared_mutex> guard(lock);
+        IDs.clear();
+        models.clear();
+        if (!status)
+            return false;
+
+        IDs.reserve(result.rowCount());
+        models.reserve(result.rowCount());
+        for (size_t i = 0; i < result.rowCount(); i++)
+        {
+            const auto ID = result.getInteger(i, 0);
+            if (!ID.has_value())
+                continue;
+            IDs[key(result[i][1], result[i][2])] = ID.value();
+            models[ID.value()] = { std::string(result[i][1]), std::string(result[i][2]) };
+        }
+        return true;
+    }
+
+    //The ID of the make and model, adding them to the database if they are new, empty if they could not be added
+    //Must be given the writer
+    std::optional<int64_t> resolve(sqlite3DB& DB, std::string_view make, std::string_view model)
+    {
+        {
+            std::shared_lock<std::shared_mutex> guard(lock);
+            const auto it = IDs.find(key(make, model));
+            if (it != IDs.end())
+                return it->second;
+        }
+
+        //The empty update has the existing row's ID returned should the pair already be stored
+        const auto [status, result] = DB.query("INSERT INTO " + serverData::tableNames[serverData::VEHICLESHARED] + "(MAKE, MODEL) VALUES (:MAK, :MOD) " +
+            "ON CONFLICT(MAKE, MODEL) DO UPDATE SET MAKE = MAKE RETURNING ID", { {":MAK", make}, {":MOD", model} });
+        if (!status || result.rowCount() == 0)
+            return {};
+        const auto ID = result.getInteger(0, 0);
+        if (ID.has_value())
+            add(ID.value(), make, model);
+        return ID;
+    }
+
+    //The make and model with that ID, read through the given connection should it not yet be known, empty if there is none
+    std::optional<model> find(sqlite3DB& reader, std::optional<int64_t> ID)
+    {
+        if (!ID.has_value())
+            return {};
+        {
+            std::shared_lock<std::shared_mutex> guard(lock);
+            const auto it = models.find(ID.value());
+            if (it != models.end())
+                return it->second;
+        }
+
+        const auto [status, result] = reader.query("SELECT MAKE, MODEL FROM " + serverData::tableNames[serverData::VEHICLESHARED] + " WHERE ID = :ID", { {":ID", ID.value()} });
+        if (!status || result.rowCount() == 0)
+            return {};
+        add(ID.value(), result[0][0], result[0][1]);
+        return model{ std::string(result[0][0]), std::string(result[0][1]) };
+    }
+};
@@ -1,6 +1,16 @@
 #pragma once
 #include "Network.h"
 #include "Response.h"
+#include "Executor.h"
+#include "PartsCatalogue.h"
+
+//Prices (in pence) and quantities are stored as whole numbers, the parts catalogue holds nothing else
+inline bool isWholeNumber(std::string_view val)
+{
+    int64_t number;
+    const auto result = std::from_chars(val.data(), val.data() + val.size(), number);
+    return result.ec == std::errc() && result.ptr == val.data() + val.size();
+}
 
 namespace webRoute
 {
@@ -22,10 +32,10 @@ namespace webRoute
             return;
         }
 
-        const auto [status, result] = serverData::database->query("INSERT INTO " + serverData::tableNames[serverData::SUPPLIERS] + " (ID, NAME, PHONE, EMAIL) VALUES (NULL, :NAM, :PHO, :EMA);", {
+        const auto [status, result] = serverData::database->query("INSERT INTO " + serverData::tableNames[serverData::SUPPLIERS] + " (ID, NAME, PHONE, EMAIL) VALUES (NULL, :NAM, :PHO, :EMA) RETURNING ID, NAME;", {
                 {":NAM", std::string(b.getElement("name"))},
-                {":PHO", b.hasElement("phone") ? std::string(b.getElement("phone")) : "NULL"},
-                {":EMA", b.hasElement("email") ? std::string(b.getElement("email")) : "NULL"} });
+                {":PHO", b.hasElement("phone") ? SQLValue(b.getElement("phone")) : SQLValue(nullptr)},
+                {":EMA", b.hasElement("email") ? SQLValue(b.getElement("email")) : SQLValue(nullptr)} });
 
         if (!status)
         {
@@ -34,6 +44,9 @@ namespace webRoute
         }
         else
         {
+            const auto ID = result.getInteger(0, 0);
+            if (ID.has_value())
+                serverData::catalogue->setSupplier(ID.value(), result[0][1]);
             std::cout << "Session (" << serverData::auth->getSessionID(req).value() << ") created new supplier (\"" << b.getElement("name") << "\").\n";
         }
         res->end();
@@ -67,7 +80,7 @@ namespace webRoute
             return;
         }
 
-        const auto [status, result] = serverData::database->query("UPDATE " + serverData::tableNames[serverData::SUPPLIERS] + " SET " + updateStatement + " WHERE NAME = :NAM", { {":NAM", b.getElement("name")} });
+        const auto [status, result] = serverData::database->query("UPDATE " + serverData::tableNames[serverData::SUPPLIERS] + " SET " + updateStatement + " WHERE NAME = :NAM RETURNING ID, NAME", { {":NAM", b.getElement("name")} });
 
         if (!status)
         {
@@ -76,6 +89,13 @@ namespace webRoute
         }
         else
         {
+            //Parts are listed with their supplier's name, which may have changed
+            for (size_t i = 0; i < result.rowCount(); i++)
+            {
+                const auto ID = result.getInteger(i, 0);
+                if (ID.has_value())
+                    serverData::catalogue->setSupplier(ID.value(), result[i][1]);
+            }
             std::cout << "Session (" << serverData::auth->getSessionID(req).value() << ") updated supplier (\"" << b.getElement("name") << "\").\n";
         }
         res->end();
@@ -99,40 +119,74 @@ namespace webRoute
             return;
         }
 
-        std::cout << "Session (" << serverData::auth->getSessionID(req).value() << ") searched for supplier with keyword \"" << q.getElement("searchterm") << "\".\n";
-
-        const auto [status, result] = serverData::database->query("SELECT ID, NAME, PHONE, EMAIL FROM " + serverData::tableNames[serverData::SUPPLIERS] + 
-            " WHERE NAME LIKE :VAL OR NAME LIKE :VAL OR PHONE LIKE :VAL OR EMAIL LIKE :VAL",
-            { {":VAL", generateLIKEArgument(q.getElement("searchterm"))} });
-        if (!status)
+        const auto page = pageRequest::fromQuery(q);
+        if (!page.has_value())
         {
-            //Internal Server Error
-            res->writeStatus(HTTPCodes::INTERNALERROR);
+            //Bad Request - Invalid arguments
+            res->writeStatus(HTTPCodes::BADREQUEST);
             res->end();
             return;
         }
 
-        if (result.rowCount() != 0)
-        {
-            responseWrapper response;
-            for (size_t i = 0; i < result.rowCount(); i++)
-            {
-                responseWrapper temp;
-                temp.add("ID", result[i][0]);
-                temp.add("Name", result[i][1]);
-                temp.add("Phone", result[i][2]);
-                temp.add("Email", result[i][3]);
-                response.add("Suppliers", std::move(temp));
-            }
-            res->tryEnd(response.toData(false));
+        std::cout << "Session (" << serverData::auth->getSessionID(req).value() << ") searched for supplier with keyword \"" << q.getElement("searchterm") << "\".\n";
+
+        const entityTag tag("/part/supplier/search", req->getQuery(), { serverData::SUPPLIERS, serverData::SUPPLIERSSEARCH });
+        if (tag.answer(res, req))
             return;
-        }
-        else
-        {
-            //No content
-            res->writeStatus(HTTPCodes::NOTFOUND);
-        }
-        res->end();
+
+        //The search runs on a database thread, in parallel with other reads
+        serverData::executor->submit(res, [q, page = page.value(), tag = tag.value()](sqlite3DB& reader) -> routeResult
+            {
+                const auto& searchTerm = q.getElement("searchterm");
+                //Longer terms are found through the full text index, best matches first, rather than by scanning every supplier
+                const bool indexed = isTrigramSearchable(searchTerm);
+                const std::string argument = indexed ? generateMATCHArgument(searchTerm) : generateLIKEArgument(searchTerm);
+                std::string SQL = indexed ?
+                    "SELECT S.ID, S.NAME, S.PHONE, S.EMAIL, F.RANK FROM " + serverData::tableNames[serverData::SUPPLIERSSEARCH] + " AS F" +
+                        " INNER JOIN " + serverData::tableNames[serverData::SUPPLIERS] + " AS S ON S.ID = F.ROWID" +
+                        " WHERE F." + serverData::tableNames[serverData::SUPPLIERSSEARCH] + " MATCH :VAL" :
+                    "SELECT ID, NAME, PHONE, EMAIL FROM " + serverData::tableNames[serverData::SUPPLIERS] +
+                        " WHERE (NAME LIKE :VAL OR PHONE LIKE :VAL OR EMAIL LIKE :VAL)";
+                SQLParams params{ {":VAL", argument} };
+                if (!page.apply(SQL, params, indexed ? "S.ID" : "ID", indexed))
+                {
+                    //Bad Request - Invalid arguments
+                    return { HTTPCodes::BADREQUEST };
+                }
+
+                //Suppliers rarely change, so the same search is answered from the result cache until they do
+                const auto [status, result] = reader.cachedQuery(SQL, params);
+                if (!status)
+                {
+                    //Internal Server Error
+                    return { HTTPCodes::INTERNALERROR };
+                }
+
+                if (result.rowCount() != 0)
+                {
+                    responseWrapper response;
+                    const size_t rows = std::min<size_t>(result.rowCount(), page.getLimit());
+                    for (size_t i = 0; i < rows; i++)
+                    {
+                        responseWrapper temp;
+                        temp.add("ID", result[i][0]);
+                        temp.add("Name", result[i][1]);
+                        temp.add("Phone", result[i][2]);
+                        temp.add("Email", result[i][3]);
+                        response.add("Suppliers", std::move(temp));
+                    }
+                    //Only a page with rows after it gives a cursor
+                    const bool more = result.rowCount() > rows;
+                    response.add("next", !more ? "" : indexed ?
+                        pageRequest::rankCursor(result.getReal(rows - 1, 4).value_or(0), result.getInteger(rows - 1, 0).value_or(0)) : std::string(result[rows - 1][0]));
+                    return { HTTPCodes::OK, response.toData(false), tag };
+                }
+                else
+                {
+                    //No content
+                    return { HTTPCodes::NOTFOUND };
+                }
+            });
     }
 
     void selectSupplier(uWS::HttpResponse<true>* res, uWS::HttpRequest* req, const body& b, const query& q)
@@ -155,32 +209,36 @@ namespace webRoute
 
         std::cout << "Session (" << serverData::auth->getSessionID(req).value() << ") selected supplier (\"" << q.getElement("ID") << "\").\n";
 
-        const auto [status, result] = serverData::database->query("SELECT ID, NAME, PHONE, EMAIL FROM " + serverData::tableNames[serverData::SUPPLIERS] + " WHERE ID = :ID",
-            { {":ID", q.getElement("ID")} });
-        if (!status)
-        {
-            //Internal Server Error
-            res->writeStatus(HTTPCodes::INTERNALERROR);
-            res->end();
+        const entityTag tag("/part/supplier/select", req->getQuery(), { serverData::SUPPLIERS });
+        if (tag.answer(res, req))
             return;
-        }
 
-        if (result.rowCount() != 0)
-        {
-            responseWrapper response;
-            response.add("ID", result[0][0]);
-            response.add("Name", result[0][1]);
-            response.add("Phone", result[0][2]);
-            response.add("Email", result[0][3]);
-            res->tryEnd(response.toData(false));
-            return;
-        }
-        else
-        {
-            //No content
-            res->writeStatus(HTTPCodes::NOTFOUND);
-        }
-        res->end();
+        //The lookup runs on a database thread, in parallel with other reads
+        serverData::executor->submit(res, [q, tag = tag.value()](sqlite3DB& reader) -> routeResult
+            {
+                const auto [status, result] = reader.cachedQuery("SELECT ID, NAME, PHONE, EMAIL FROM " + serverData::tableNames[serverData::SUPPLIERS] + " WHERE ID = :ID",
+                    { {":ID", asInteger(q.getElement("ID"))} });
+                if (!status)
+                {
+                    //Internal Server Error
+                    return { HTTPCodes::INTERNALERROR };
+                }
+
+                if (result.rowCount() != 0)
+                {
+                    responseWrapper response;
+                    response.add("ID", result[0][0]);
+                    response.add("Name", result[0][1]);
+                    response.add("Phone", result[0][2]);
+                    response.add("Email", result[0][3]);
+                    return { HTTPCodes::OK, response.toData(false), tag };
+                }
+                else
+                {
+                    //No content
+                    return { HTTPCodes::NOTFOUND };
+                }
+            });
     }
 
 
@@ -203,7 +261,7 @@ namespace webRoute
             return;
         }
 
-        const auto [status, result] = serverData::database->query("INSERT INTO " + serverData::tableNames[serverData::PARTGROUPS] + " (NAME) VALUES (:NAM);", {{":NAM", std::string(b.getElement("name"))}});
+        const auto [status, result] = serverData::database->query("INSERT INTO " + serverData::tableNames[serverData::PARTGROUPS] + " (NAME) VALUES (:NAM) RETURNING ID;", {{":NAM", std::string(b.getElement("name"))}});
 
         if (!status)
         {
@@ -212,6 +270,10 @@ namespace webRoute
         }
         else
         {
+            //Parts may only be found by a group once it exists
+            const auto ID = result.getInteger(0, 0);
+            if (ID.has_value())
+                serverData::catalogue->addGroup(ID.value());
             std::cout << "Session (" << serverData::auth->getSessionID(req).value() << ") created new part group (\"" << b.getElement("name") << "\").\n";
         }
         res->end();
@@ -235,8 +297,8 @@ namespace webRoute
             return;
         }
 
-        const auto [status, result] = serverData::database->query("UPDATE " + serverData::tableNames[serverData::PARTGROUPS] + " SET NAME = :RNM WHERE NAME = :NAM", 
-            { {":NAM", b.getElement("name")}, {":RNM", b.getElement("rename")} });
+        const SQLCode status = serverData::database->query("UPDATE " + serverData::tableNames[serverData::PARTGROUPS] + " SET NAME = :RNM WHERE NAME = :NAM", 
+            { {":NAM", b.getElement("name")}, {":RNM", b.getElement("rename")} }).first;
 
         if (!status)
         {
@@ -268,38 +330,63 @@ namespace webRoute
             return;
         }
 
-        const auto [status, result] =
-            serverData::database->query("SELECT ID, NAME FROM " + serverData::tableNames[serverData::PARTGROUPS] +
-                " WHERE NAME LIKE :NAM", { {":NAM", generateLIKEArgument(q.getElement("name"))} });
-
-        if (!status)
+        const auto page = pageRequest::fromQuery(q);
+        if (!page.has_value())
         {
-            //Internal server error
-            res->writeStatus(HTTPCodes::INTERNALERROR);
+            //Bad Request - Invalid arguments
+            res->writeStatus(HTTPCodes::BADREQUEST);
             res->end();
             return;
         }
 
-        if (result.rowCount() != 0)
-        {
-            responseWrapper response;
-            for (size_t i = 0; i < result.rowCount(); i++)
-            {
-                responseWrapper temp;
-                temp.add("ID", result[i][0]);
-                temp.add("Name", result[i][1]);
-                response.add("Groups", std::move(temp), true);
-            }
+        const auto sessionID = serverData::auth->getSessionID(req).value();
 
-            std::cout << "Session (" << serverData::auth->getSessionID(req).value() << ") searched part groups for " << q.getElement("name") << ".\n";
-            res->tryEnd(response.toData(false));
-        }
-        else
-        {
-            //No content
-            res->writeStatus(HTTPCodes::NOTFOUND);
-            res->end();
-        }
+        const entityTag tag("/part/group/search", req->getQuery(), { serverData::PARTGROUPS });
+        if (tag.answer(res, req))
+            return;
+
+        //The search runs on a database thread, in parallel with other reads
+        serverData::executor->submit(res, [q, sessionID, page = page.value(), tag = tag.value()](sqlite3DB& reader) -> routeResult
+            {
+                const std::string argument = generateLIKEArgument(q.getElement("name"));
+                std::string SQL = "SELECT ID, NAME FROM " + serverData::tableNames[serverData::PARTGROUPS] + " WHERE NAME LIKE :NAM";
+                SQLParams params{ {":NAM", argument} };
+                if (!page.apply(SQL, params, "ID", false))
+                {
+                    //Bad Request - Invalid arguments
+                    return { HTTPCodes::BADREQUEST };
+                }
+                const auto [status, result] = reader.cachedQuery(SQL, params);
+
+                if (!status)
+                {
+                    //Internal server error
+                    return { HTTPCodes::INTERNALERROR };
+                }
+
+                if (result.rowCount() != 0)
+                {
+                    responseWrapper response;
+                    const size_t rows = std::min<size_t>(result.rowCount(), page.getLimit());
+                    for (size_t i = 0; i < rows; i++)
+                    {
+                        responseWrapper temp;
+                        temp.add("ID", result[i][0]);
+                        temp.add("Name", result[i][1]);
+                        response.add("Groups", std::move(temp), true);
+                    }
+                    //Only a page with rows after it gives a cursor
+                    response.add("next", result.rowCount() > rows ? result[rows - 1][0] : "");
+
+                    std::cout << "Session (" << sessionID << ") searched part groups for " << q.getElement("name") << ".\n";
+                    return { HTTPCodes::OK, response.toData(false), tag };
+                }
+                else
+                {
+                    //No content
+                    return { HTTPCodes::NOTFOUND };
+                }
+            });
     }
 
     void selectPartGroup(uWS::HttpResponse<true>* res, uWS::HttpRequest* req, const body& b, const query& q)
@@ -320,39 +407,46 @@ namespace webRoute
             return;
         }
 
-        const auto [status, result] =
-            serverData::database->query("SELECT ID, NAME FROM " + serverData::tableNames[serverData::PARTGROUPS] +
-                " WHERE ID = :ID", { {":ID", q.getElement("ID")} });
+        const auto sessionID = serverData::auth->getSessionID(req).value();
 
-        if (!status)
-        {
-            //Internal server error
-            res->writeStatus(HTTPCodes::INTERNALERROR);
-            res->end();
+        const entityTag tag("/part/group/select", req->getQuery(), { serverData::PARTGROUPS });
+        if (tag.answer(res, req))
             return;
-        }
-
-        std::cout << "Session (" << serverData::auth->getSessionID(req).value() << ") selected group " << q.getElement("ID") << ".\n";
 
-        if (result.rowCount() != 0)
-        {
-            responseWrapper response;
-            response.add("ID", result[0][0]);
-            response.add("Name", result[0][1]);
-            res->tryEnd(response.toData(false));
-        }
-        else
-        {
-            res->writeStatus(HTTPCodes::NOTFOUND);
-            res->end();
-        }
+        //The lookup runs on a database thread, in parallel with other reads
+        serverData::executor->submit(res, [q, sessionID, tag = tag.value()](sqlite3DB& reader) -> routeResult
+            {
+                const auto [status, result] =
+                    reader.cachedQuery("SELECT ID, NAME FROM " + serverData::tableNames[serverData::PARTGROUPS] +
+                        " WHERE ID = :ID", { {":ID", asInteger(q.getElement("ID"))} });
+
+                if (!status)
+                {
+                    //Internal server error
+                    return { HTTPCodes::INTERNALERROR };
+                }
+
+                std::cout << "Session (" << sessionID << ") selected group " << q.getElement("ID") << ".\n";
+
+                if (result.rowCount() != 0)
+                {
+                    responseWrapper response;
+                    response.add("ID", result[0][0]);
+                    response.add("Name", result[0][1]);
+                    return { HTTPCodes::OK, response.toData(false), tag };
+                }
+                else
+                {
+                    return { HTTPCodes::NOTFOUND };
+                }
+            });
     }
 
 
     void createPart(uWS::HttpResponse<true>* res, uWS::HttpRequest* req, const body& b, const query& q)
     {
         if (!b.containsAll({ "name", "quantity", "supplier", "price" }) || 
-            b.getElement("name").empty() || b.getElement("quantity").empty() || b.getElement("supplier").empty() || b.getElement("price").empty())
+            b.getElement("name").empty() || b.getElement("supplier").empty() || !isWholeNumber(b.getElement("quantity")) || !isWholeNumber(b.getElement("price")))
         {
             //Bad Request - Invalid arguments
             res->writeStatus(HTTPCodes::BADREQUEST);
@@ -368,7 +462,7 @@ namespace webRoute
             return;
         }
 
-        std::string_view groupID = "NULL";
+        SQLValue groupID = nullptr;
 
         if (b.hasElement("group"))
         {
@@ -380,14 +474,15 @@ namespace webRoute
                 res->end();
                 return;
             }
+            groupID = groupresult.getInteger(0, 0).value();
         }
 
 
-        const auto [status, result] = serverData::database->query("INSERT INTO " + serverData::tableNames[serverData::PARTS] + " (ID, NAME, QUANTITY, SUPPLIER, PRICE, SIMILAR) VALUES (NULL, :NAM, :QUA, :SUP, :PRI, :SIM);", {
+        const auto [status, result] = serverData::database->query("INSERT INTO " + serverData::tableNames[serverData::PARTS] + " (ID, NAME, QUANTITY, SUPPLIER, PRICE, SIMILAR) VALUES (NULL, :NAM, :QUA, :SUP, :PRI, :SIM) RETURNING ID;", {
                 {":NAM", b.getElement("name")},
-                {":QUA", b.getElement("quantity")},
-                {":SUP", b.getElement("supplier")},
-                {":PRI", b.getElement("price")},
+                {":QUA", asInteger(b.getElement("quantity"))},
+                {":SUP", asInteger(b.getElement("supplier"))},
+                {":PRI", asInteger(b.getElement("price"))},
                 {":SIM", groupID} });
 
         if (!status)
@@ -397,6 +492,9 @@ namespace webRoute
         }
         else
         {
+            const auto ID = result.getInteger(0, 0);
+            if (!ID.has_value() || !serverData::catalogue->refreshPart(*serverData::database, ID.value()))
+                std::cout << "Failed to add part to the catalogue.\n";
             std::cout << "Session (" << serverData::auth->getSessionID(req).value() << ") created new part (\"" << b.getElement("name") << "\").\n";
         }
         res->end();
@@ -411,6 +509,17 @@ namespace webRoute
             res->end();
             return;
         }
+        //Empty values are left unchanged
+        for (const auto& i : { "quantity", "price" })
+        {
+            if (b.hasElement(i) && !b.getElement(i).empty() && !isWholeNumber(b.getElement(i)))
+            {
+                //Bad Request - Invalid arguments
+                res->writeStatus(HTTPCodes::BADREQUEST);
+                res->end();
+                return;
+            }
+        }
 
         if (!serverData::auth->verify(req, authLevel::manager))
         {
@@ -430,15 +539,40 @@ namespace webRoute
             return;
         }
 
-        const auto [status, result] = serverData::database->query("UPDATE " + serverData::tableNames[serverData::PARTS] + " SET " + updateStatement + " WHERE ID = :ID", { {":ID", b.getElement("ID")} });
+        //A new price changes the stored totals of services using the part, which are written in the same transaction
+        auto transaction = serverData::database->transaction();
+        if (!transaction)
+        {
+            //Internal server error
+            res->writeStatus(HTTPCodes::INTERNALERROR);
+            res->end();
+            return;
+        }
 
-        if (!status)
+        const auto [status, result] = serverData::database->query("UPDATE " + serverData::tableNames[serverData::PARTS] + " SET " + updateStatement + " WHERE ID = :ID RETURNING ID", { {":ID", asInteger(b.getElement("ID"))} });
+
+        bool totalsUpdated = true;
+        if (status && b.hasElement("price"))
+        {
+            //Closed services keep the total they were closed with
+            totalsUpdated = serverData::database->query("UPDATE " + serverData::tableNames[serverData::SERVICES] + " AS S SET TOTAL = " +
+                "COALESCE((SELECT SUM(P.PRICE * PS.QUANTITY) FROM " + serverData::tableNames[serverData::PARTSINSERVICE] + " AS PS" +
+                " INNER JOIN " + serverData::tableNames[serverData::PARTS] + " AS P ON PS.PART = P.ID WHERE PS.SERVICE = S.ID), 0)" +
+                " WHERE S.STATUS != 'closed' AND S.ID IN (SELECT SERVICE FROM " + serverData::tableNames[serverData::PARTSINSERVICE] + " WHERE PART = :ID)",
+                { {":ID", asInteger(b.getElement("ID"))} }).first;
+        }
+
+        if (!status || !totalsUpdated || !transaction.commit())
         {
             //Internal server error
             res->writeStatus(HTTPCodes::INTERNALERROR);
         }
         else
         {
+            //Nothing is returned if there was no such part
+            const auto ID = result.rowCount() != 0 ? result.getInteger(0, 0) : std::nullopt;
+            if (ID.has_value() && !serverData::catalogue->refreshPart(*serverData::database, ID.value()))
+                std::cout << "Failed to update part in the catalogue.\n";
             std::cout << "Session (" << serverData::auth->getSessionID(req).value() << ") updated part (\"" << b.getElement("ID") << "\").\n";
         }
         res->end();
@@ -462,55 +596,37 @@ namespace webRoute
             return;
         }
 
-        std::unordered_map<std::string_view, std::string_view> searchVals;
-        std::string likeName;
-        if (q.hasElement("name", true))
-        {
-            likeName = generateLIKEArgument(q.getElement("name"));
-            searchVals[":NAM"] = likeName;
-        }
-        if (q.hasElement("group", true))
-            searchVals[":ID"] = q.getElement("group");
-
-        std::string searchTerm;
-        if (q.hasElement("name", true))
+        const auto page = pageRequest::fromQuery(q);
+        if (!page.has_value())
         {
-            searchTerm += " P.NAME LIKE :NAM";
-            if (q.hasElement("group", true))
-                searchTerm += " AND";
+            //Bad Request - Invalid arguments
+            res->writeStatus(HTTPCodes::BADREQUEST);
+            res->end();
+            return;
         }
-        if (q.hasElement("group", true))
-            searchTerm += " G.ID = :ID";
 
-        const auto [status, result] =
-            serverData::database->query("SELECT P.ID, P.NAME, P.PRICE, P.QUANTITY, S.NAME, G.ID FROM " + serverData::tableNames[serverData::PARTS] +
-                " AS P LEFT JOIN " + serverData::tableNames[serverData::PARTGROUPS] + " AS G ON P.SIMILAR = G.ID " +
-                "INNER JOIN " + serverData::tableNames[serverData::SUPPLIERS] +
-                " AS S ON P.SUPPLIER = S.ID WHERE " + searchTerm, searchVals);
-
-        if (!status)
+        //Answered from the in-memory catalogue, on the loop, as it takes no longer than handing the work to a database thread would
+        const auto found = serverData::catalogue->search(
+            q.hasElement("name", true) ? std::optional<std::string_view>(q.getElement("name")) : std::nullopt,
+            q.hasElement("group", true) ? std::optional<std::string_view>(q.getElement("group")) : std::nullopt, page.value());
+        if (!found.valid)
         {
-            //Internal server error
-            res->writeStatus(HTTPCodes::INTERNALERROR);
+            //Bad Request - Invalid arguments
+            res->writeStatus(HTTPCodes::BADREQUEST);
             res->end();
             return;
         }
 
-        responseWrapper response;
-        for (size_t i = 0; i < result.rowCount(); i++)
+        responseListWriter response("Parts", true);
+        for (const size_t row : found.rows)
         {
-            responseWrapper temp;
-            temp.add("ID", result[i][0]);
-            temp.add("Name", result[i][1]);
-            temp.add("Price", result[i][2]);
-            temp.add("Quantity", result[i][3]);
-            temp.add("Supplier", result[i][4]);
-            temp.add("GroupID", result[i][5]);
-            response.add("Parts", std::move(temp), true);
+            response.add(serverData::catalogue->describe(row));
         }
 
         std::cout << "Session (" << serverData::auth->getSessionID(req).value() << ") searched parts for " << (q.hasElement("name", true) ? q.getElement("name") : q.getElement("group")) << ".\n";
-        res->tryEnd(response.toData(false));
+        responseWrapper fields;
+        fields.add("next", found.next);
+        res->end(response.finish(fields));
     }
 
     void selectPart(uWS::HttpResponse<true>* res, uWS::HttpRequest* req, const body& b, const query& q)
@@ -531,36 +647,29 @@ namespace webRoute
             return;
         }
 
-        const auto [status, result] =
-            serverData::database->query("SELECT P.ID, P.NAME, P.PRICE, P.QUANTITY, S.NAME, G.ID FROM " + serverData::tableNames[serverData::PARTS] +
-                " AS P LEFT JOIN " + serverData::tableNames[serverData::PARTGROUPS] + " AS G INNER JOIN " + serverData::tableNames[serverData::SUPPLIERS] +
-                " AS S WHERE P.ID = :ID", { {":ID", q.getElement("ID")} });
+        const auto sessionID = serverData::auth->getSessionID(req).value();
 
-        if (!status)
-        {
-            //Internal server error
-            res->writeStatus(HTTPCodes::INTERNALERROR);
-            res->end();
+        //A client already holding the current response is answered without reading anything
+        const entityTag tag("/part/select", req->getQuery(), { serverData::PARTS, serverData::PARTGROUPS, serverData::SUPPLIERS });
+        if (tag.answer(res, req))
             return;
-        }
 
-        std::cout << "Session (" << serverData::auth->getSessionID(req).value() << ") selected part " << q.getElement("ID") << ".\n";
+        std::cout << "Session (" << sessionID << ") selected part " << q.getElement("ID") << ".\n";
 
-        if (result.rowCount() != 0)
-        {
-            responseWrapper response;
-            response.add("ID", result[0][0]);
-            response.add("Name", result[0][1]);
-            response.add("Price", result[0][2]);
-            response.add("Quantity", result[0][3]);
-            response.add("Supplier", result[0][4]);
-            response.add("GroupID", result[0][5]);
-            res->tryEnd(response.toData(false));
-        }
-        else
+        int64_t ID;
+        const auto& val = q.getElement("ID");
+        const auto parsed = std::from_chars(val.data(), val.data() + val.size(), ID);
+        const auto row = parsed.ec == std::errc() && parsed.ptr == val.data() + val.size() ? serverData::catalogue->find(ID) : std::nullopt;
+        if (!row.has_value())
         {
+            //Not found - No part with that ID
             res->writeStatus(HTTPCodes::NOTFOUND);
             res->end();
+            return;
         }
+
+        res->writeStatus(HTTPCodes::OK);
+        res->writeHeader("ETag", tag.value());
+        res->end(serverData::catalogue->describe(row.value()).toData(false));
     }
 }
\ No newline at end of file
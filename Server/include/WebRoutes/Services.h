@@ -1,21 +1,35 @@
 #pragma once
 #include "Network.h"
 #include "Response.h"
+#include "WriteBatcher.h"
+#include "Executor.h"
+#include "Ownership.h"
+
+//Prices are integers in minor units (pence), so totals are kept exactly
+//Moves a service's stored parts total and count by a number of a part added to (or, if negative, removed from) it
+//Must run in the same transaction as the change to the service's parts, fails if the part does not exist
+//Closed services keep the total they were closed with (part price changes pass them by), so their parts cannot change either
+//The service's ID is returned if it was adjusted, no rows if it is closed or does not exist
+inline std::pair<SQLCode, SQLResult> adjustServiceTotal(const SQLValue& service, const SQLValue& part, const SQLValue& quantity)
+{
+    return serverData::database->query("UPDATE " + serverData::tableNames[serverData::SERVICES] +
+        " SET TOTAL = TOTAL + :QNT * (SELECT PRICE FROM " + serverData::tableNames[serverData::PARTS] + " WHERE ID = :PRT), PARTCOUNT = PARTCOUNT + :QNT WHERE ID = :SRV AND STATUS != 'closed' RETURNING ID",
+        { {":SRV", service}, {":PRT", part}, {":QNT", quantity} });
+}
 
-//Simple string conversion function
-std::optional<double> getPartPrice(std::string_view price, std::string_view quantity)
+//Groups the rows of a result by the service ID held in one of its columns, keeping the order they were returned in
+//Empty if any row's service ID is not an integer
+inline std::optional<std::unordered_map<int64_t, std::vector<size_t>>> groupByService(const SQLResult& result, size_t serviceCol)
 {
+    std::unordered_map<int64_t, std::vector<size_t>> ret;
+    for (size_t i = 0; i < result.rowCount(); i++)
     {
-        double partPrice;
-        size_t partQuantity;
-        const auto conv = std::from_chars(price.data(), price.data() + price.size(), partPrice);
-        const auto conv_b = std::from_chars(quantity.data(), quantity.data() + quantity.size(), partQuantity);
-        if (conv.ec != std::errc() || conv_b.ec != std::errc())
-        {
+        const auto service = result.getInteger(i, serviceCol);
+        if (!service.has_value())
             return {};
-        }
-        return partPrice * partQuantity;
+        ret[service.value()].push_back(i);
     }
+    return ret;
 }
 
 namespace webRoute
@@ -29,17 +43,16 @@ namespace webRoute
             res->end();
             return;
         }
-        if (!serverData::auth->verify(req, authLevel::manager))
         {
-            const auto [status, result] = serverData::database->query("SELECT OWNER FROM " + serverData::tableNames[serverData::VEHICLES] + " WHERE ID = :VID", { {":VID", b.getElement("VID")} });
-            if (!status)
+            const auto owner = serverData::owners->vehicleOwner(b.getElement("VID"));
+            if (!owner.has_value())
             {
-                //Internal server error
-                res->writeStatus(HTTPCodes::INTERNALERROR);
+                //Not found - No vehicle with that ID
+                res->writeStatus(HTTPCodes::NOTFOUND);
                 res->end();
                 return;
             }
-            if (!serverData::auth->isSessionUserFromID(req, result[0][0]))
+            if (!serverData::auth->isSessionUser(req, owner) && !serverData::auth->verify(req, authLevel::manager))
             {
                 //Forbidden - Insufficient permissions
                 res->writeStatus(HTTPCodes::FORBIDDEN);
@@ -48,18 +61,10 @@ namespace webRoute
             }
         }
 
-        const auto [sStatus, sResult] = serverData::database->query("INSERT INTO " + serverData::tableNames[serverData::SERVICESHARED] + "(VEHICLE, REQUESTED, REQUEST) VALUES " + 
-            "(:ID, (SELECT date('now')), :REQ)",
-            { {":ID", b.getElement("VID")}, {":REQ", b.getElement("request")} });
-        if (!sStatus)
-        {
-            //Internal server error
-            res->writeStatus(HTTPCodes::INTERNALERROR);
-            res->end();
-            return;
-        }
-
-        const auto [status, result] = serverData::database->query("INSERT INTO " + serverData::tableNames[serverData::SERVICEUNAUTHORISED] + " (SERVICE) VALUES ((SELECT last_insert_rowid()))", {});
+        //New services start unauthorised
+        const auto [status, result] = serverData::database->query("INSERT INTO " + serverData::tableNames[serverData::SERVICES] + "(VEHICLE, REQUESTED, REQUEST) VALUES " + 
+            "(:ID, (SELECT date('now')), :REQ) RETURNING ID, VEHICLE",
+            { {":ID", asInteger(b.getElement("VID"))}, {":REQ", b.getElement("request")} });
 
         if (!status)
         {
@@ -68,6 +73,10 @@ namespace webRoute
         }
         else
         {
+            const auto ID = result.getInteger(0, 0);
+            const auto vehicle = result.getInteger(0, 1);
+            if (ID.has_value() && vehicle.has_value())
+                serverData::owners->addService(ID.value(), vehicle.value());
             std::cout << "Session (" << serverData::auth->getSessionID(req).value() << ") requested a new service.\n";
         }
         res->end();
@@ -90,61 +99,29 @@ namespace webRoute
             return;
         }
 
-        const auto [sStatus, sResult] = serverData::database->query("SELECT SERVICE FROM " + serverData::tableNames[serverData::SERVICEUNAUTHORISED] + " WHERE SERVICE = :ID", { {":ID", b.getElement("ID")} });
-        if (!sStatus)
-        {
-            //Internal server error
-            res->writeStatus(HTTPCodes::INTERNALERROR);
-            res->end();
-            return;
-        }
-        if (sResult.rowCount() != 1)
-        {
-            //Internal server error
-            res->writeStatus(HTTPCodes::NOTFOUND);
-            res->end();
-            return;
-        }
-
+        const auto user = serverData::auth->getSessionUser(req).value();
 
-        const auto [dStatus, dResult] = serverData::database->query("DELETE FROM " + serverData::tableNames[serverData::SERVICEUNAUTHORISED] + " WHERE SERVICE = :ID", { {":ID", b.getElement("ID")} });
-        if (!dStatus)
-        {
-            //Internal server error
-            res->writeStatus(HTTPCodes::INTERNALERROR);
-            res->end();
-            return;
-        }
-
-        std::string user = std::to_string(serverData::auth->getSessionUser(req).value());
-
-        const auto [status, result] = serverData::database->query("INSERT INTO " + serverData::tableNames[serverData::SERVICEACTIVE] + " (SERVICE, LABOUR, NOTES, AUTHORISER, QUOTE) VALUES " + 
-            "(:ID, 0, :NOT, :UID, :QOT)", {
-            {":ID", b.getElement("ID")},
-            {":NOT", b.hasElement("notes") ? b.getElement("notes") : ""},
+        //Only an unauthorised service can be authorised, the service is returned if it was
+        const auto [status, result] = serverData::database->query("UPDATE " + serverData::tableNames[serverData::SERVICES] + 
+            " SET STATUS = 'open', LABOUR = 0, NOTES = :NOT, AUTHORISER = :UID, QUOTE = :QOT WHERE ID = :ID AND STATUS = 'unauthorised' RETURNING ID", {
+            {":ID", asInteger(b.getElement("ID"))},
+            {":NOT", b.hasElement("notes") ? b.getElement("notes") : std::string_view()},
             {":UID", user},
-            {":QOT", b.getElement("quote")} });
+            {":QOT", asInteger(b.getElement("quote"))} });
 
         if (!status)
         {
-            //Note that there is no rollback, a real-world system would need to ensure both this operation and the next complete successfully
             //Internal server error
             res->writeStatus(HTTPCodes::INTERNALERROR);
-            res->end();
-            return;
         }
-
-        const auto [oStatus, oResult] = serverData::database->query("INSERT INTO " + serverData::tableNames[serverData::SERVICEOPEN] + " (SERVICE) VALUES ((SELECT last_insert_rowid()))", {});
-
-        if (!oStatus)
+        else if (result.rowCount() != 1)
         {
-            //Note that there is no rollback, a real-world system would need to ensure both this operation and the next complete successfully
-            //Internal server error
-            res->writeStatus(HTTPCodes::INTERNALERROR);
+            //Not found - No unauthorised service with that ID
+            res->writeStatus(HTTPCodes::NOTFOUND);
         }
         else
         {
-            std::cout << "Session (" << serverData::auth->getSessionID(req).value() << ") authorised a service as \"" + user + "\".\n";
+            std::cout << "Session (" << serverData::auth->getSessionID(req).value() << ") authorised a service as \"" << user << "\".\n";
         }
         res->end();
     }
@@ -176,18 +153,19 @@ namespace webRoute
             return;
         }
 
-        const auto [status, result] = serverData::database->query("UPDATE " + serverData::tableNames[serverData::SERVICEACTIVE] + " SET " + updateStatement + " WHERE ID = :ID", { {":ID", b.getElement("ID")} });
+        const auto sessionID = serverData::auth->getSessionID(req).value();
 
-        if (!status)
-        {
-            //Internal server error
-            res->writeStatus(HTTPCodes::INTERNALERROR);
-        }
-        else
-        {
-            std::cout << "Session (" << serverData::auth->getSessionID(req).value() << ") updated a service.\n";
-        }
-        res->end();
+        //The update is committed alongside any other writes arriving at the same time
+        serverData::writes->submit(res, [updateStatement, ID = std::string(b.getElement("ID"))]()
+            {
+                const auto [status, result] = serverData::database->query("UPDATE " + serverData::tableNames[serverData::SERVICES] + " SET " + updateStatement + " WHERE ID = :ID AND STATUS != 'unauthorised'", { {":ID", asInteger(ID)} });
+                //Internal server error
+                return status ? HTTPCodes::OK : HTTPCodes::INTERNALERROR;
+            },
+            [sessionID]()
+            {
+                std::cout << "Session (" << sessionID << ") updated a service.\n";
+            });
     }
 
     void closeService(uWS::HttpResponse<true>* res, uWS::HttpRequest* req, const body& b, const query& q)
@@ -206,30 +184,28 @@ namespace webRoute
             res->end();
             return;
         }
-        std::string user = std::to_string(serverData::auth->getSessionUser(req).value());
+        const auto user = serverData::auth->getSessionUser(req).value();
+
+        //Only an open service can be closed, the service is returned if it was
+        const auto [status, result] = serverData::database->query("UPDATE " + serverData::tableNames[serverData::SERVICES] +
+            " SET STATUS = 'closed', COMPLETED = (SELECT date('now')), COMPLETER = :USR, PAID = :PAD WHERE ID = :ID AND STATUS = 'open' RETURNING ID",
+            { {":ID", asInteger(b.getElement("ID"))}, {":USR", user}, {":PAD", b.getElement("paid")} });
 
-        const auto [sStatus, sResult] = serverData::database->query("INSERT INTO " + serverData::tableNames[serverData::SERVICECLOSED] + "(SERVICE, COMPLETED, COMPLETER, PAID) VALUES (:ID, (SELECT date('now')), :USR, :PAD)",
-            { {":ID", b.getElement("ID")}, {":USR", user}, {":PAD", b.getElement("paid")} });
-        if (!sStatus)
+        if (!status)
         {
             //Internal server error
             res->writeStatus(HTTPCodes::INTERNALERROR);
             res->end();
             return;
         }
-
-        const auto [dStatus, dResult] = serverData::database->query("DELETE FROM " + serverData::tableNames[serverData::SERVICEOPEN] + " WHERE SERVICE = :ID", { {":ID", b.getElement("ID")} });
-
-        if (!dStatus)
+        if (result.rowCount() != 1)
         {
-            //Note that there is no rollback, a real-world system would need to ensure both this operation and the next complete successfully
-            //Internal server error
-            res->writeStatus(HTTPCodes::INTERNALERROR);
+            //Not found - No open service with that ID
+            res->writeStatus(HTTPCodes::NOTFOUND);
             res->end();
             return;
         }
 
-
         std::cout << "Session (" << serverData::auth->getSessionID(req).value() << ") closed a service.\n";
         res->end();
     }
@@ -250,26 +226,23 @@ namespace webRoute
             res->end();
             return;
         }
-        std::string user = std::to_string(serverData::auth->getSessionUser(req).value());
+        const auto user = serverData::auth->getSessionUser(req).value();
 
-        const auto [dStatus, dResult] = serverData::database->query("DELETE FROM " + serverData::tableNames[serverData::SERVICECLOSED] + " WHERE ID = :ID", { {":ID", b.getElement("ID")} });
-
-        if (!dStatus)
+        //Only a closed service can be reopened, the service is returned if it was
+        const auto [status, result] = serverData::database->query("UPDATE " + serverData::tableNames[serverData::SERVICES] +
+            " SET STATUS = 'open', COMPLETED = NULL, COMPLETER = NULL, PAID = NULL WHERE ID = :ID AND STATUS = 'closed' RETURNING ID",
+            { {":ID", asInteger(b.getElement("ID"))} });
+        if (!status)
         {
             //Internal server error
             res->writeStatus(HTTPCodes::INTERNALERROR);
             res->end();
             return;
         }
-
-
-        const auto [sStatus, sResult] = serverData::database->query("INSERT INTO " + serverData::tableNames[serverData::SERVICEOPEN] + "(SERVICE) VALUES (:ID)",
-            { {":ID", b.getElement("ID")} });
-        if (!sStatus)
+        if (result.rowCount() != 1)
         {
-            //Note that there is no rollback, a real-world system would need to ensure both this operation and the next complete successfully
-            //Internal server error
-            res->writeStatus(HTTPCodes::INTERNALERROR);
+            //Not found - No closed service with that ID
+            res->writeStatus(HTTPCodes::NOTFOUND);
             res->end();
             return;
         }
@@ -310,50 +283,63 @@ namespace webRoute
             }
         }
 
-        const auto [searchStatus, searchResult] = serverData::database->query(
-            "SELECT ID FROM " + serverData::tableNames[serverData::PARTSINSERVICE] + " WHERE SERVICE = :SID AND PART = :PRT", { {":PRT", b.getElement("partID")}, {":SID", b.getElement("serviceID")} });
-        if (!searchStatus)
-        {
-            //Internal server error
-            res->writeStatus(HTTPCodes::INTERNALERROR);
-            res->end();
-            return;
-        }
+        const auto sessionID = serverData::auth->getSessionID(req).value();
+        //Whether the parts were merged into an existing entry or added as a new one, only known once the write has run
+        auto added = std::make_shared<std::string_view>();
 
-        if (searchResult.rowCount() != 0)
-        {
-            const auto [status, result] = serverData::database->query("UPDATE " + serverData::tableNames[serverData::PARTSINSERVICE] + " SET QUANTITY = QUANTITY + :QNT WHERE ID = :ID",
-                { {":ID", searchResult[0][0]}, {":QNT", b.hasElement("quantity") ? b.getElement("quantity") : "1"} });
-            if (!status)
-            {
-                //Internal server error
-                res->writeStatus(HTTPCodes::INTERNALERROR);
-            }
-            else
+        //The parts are added alongside any other writes arriving at the same time, the batch's savepoint keeps the lookup and write together
+        serverData::writes->submit(res, [b, added]()
             {
-                std::cout << "Session (" << serverData::auth->getSessionID(req).value() << ") added existing parts to a service.\n";
-            }
-            res->end();
-            return;
-        }
-        else
-        {
-            const auto [status, result] = serverData::database->query("INSERT INTO " + serverData::tableNames[serverData::PARTSINSERVICE] + "(PART, QUANTITY, SERVICE) VALUES " +
-                "(:PRT, :QNT, :SRV)",
-                { {":PRT", b.getElement("partID")}, {":QNT", b.hasElement("quantity") ? b.getElement("quantity") : "1"}, {":SRV", b.getElement("serviceID")} });
-            if (!status)
-            {
-                //Internal server error
-                res->writeStatus(HTTPCodes::INTERNALERROR);
-                res->end();
-                return;
-            }
-        }
+                const auto [searchStatus, searchResult] = serverData::database->query(
+                    "SELECT ID FROM " + serverData::tableNames[serverData::PARTSINSERVICE] + " WHERE SERVICE = :SID AND PART = :PRT", { {":PRT", asInteger(b.getElement("partID"))}, {":SID", asInteger(b.getElement("serviceID"))} });
+                if (!searchStatus)
+                {
+                    //Internal server error
+                    return HTTPCodes::INTERNALERROR;
+                }
 
-        {
-            std::cout << "Session (" << serverData::auth->getSessionID(req).value() << ") added new parts to a service.\n";
-        }
-        res->end();
+                const SQLValue quantity = b.hasElement("quantity") ? asInteger(b.getElement("quantity")) : SQLValue(1);
+                //The service's total moves with its parts, under the same savepoint
+                const auto [totalStatus, totalResult] = adjustServiceTotal(asInteger(b.getElement("serviceID")), asInteger(b.getElement("partID")), quantity);
+                if (!totalStatus)
+                {
+                    //Internal server error
+                    return HTTPCodes::INTERNALERROR;
+                }
+                if (totalResult.rowCount() == 0)
+                {
+                    //Conflict - The service is closed (or does not exist)
+                    return HTTPCodes::CONFLICT;
+                }
+
+                if (searchResult.rowCount() != 0)
+                {
+                    const auto [status, result] = serverData::database->query("UPDATE " + serverData::tableNames[serverData::PARTSINSERVICE] + " SET QUANTITY = QUANTITY + :QNT WHERE ID = :ID",
+                        { {":ID", asInteger(searchResult[0][0])}, {":QNT", quantity} });
+                    if (!status)
+                    {
+                        //Internal server error
+                        return HTTPCodes::INTERNALERROR;
+                    }
+                    *added = "existing";
+                    return HTTPCodes::OK;
+                }
+
+                const auto [status, result] = serverData::database->query("INSERT INTO " + serverData::tableNames[serverData::PARTSINSERVICE] + "(PART, QUANTITY, SERVICE) VALUES " +
+                    "(:PRT, :QNT, :SRV)",
+                    { {":PRT", asInteger(b.getElement("partID"))}, {":QNT", quantity}, {":SRV", asInteger(b.getElement("serviceID"))} });
+                if (!status)
+                {
+                    //Internal server error
+                    return HTTPCodes::INTERNALERROR;
+                }
+                *added = "new";
+                return HTTPCodes::OK;
+            },
+            [sessionID, added]()
+            {
+                std::cout << "Session (" << sessionID << ") added " << *added << " parts to a service.\n";
+            });
     }
 
     void removePartFromService(uWS::HttpResponse<true>* res, uWS::HttpRequest* req, const body& b, const query& q)
@@ -373,8 +359,18 @@ namespace webRoute
             return;
         }
 
+        //The service's total changes with its parts, so both are written in one transaction
+        auto transaction = serverData::database->transaction();
+        if (!transaction)
+        {
+            //Internal server error
+            res->writeStatus(HTTPCodes::INTERNALERROR);
+            res->end();
+            return;
+        }
+
         const auto [searchStatus, searchResult] = serverData::database->query(
-            "SELECT QUANTITY FROM " + serverData::tableNames[serverData::PARTSINSERVICE] + " WHERE ID = :ID", { {":ID", b.getElement("entry")} });
+            "SELECT QUANTITY, SERVICE, PART FROM " + serverData::tableNames[serverData::PARTSINSERVICE] + " WHERE ID = :ID", { {":ID", asInteger(b.getElement("entry"))} });
         if (!searchStatus)
         {
             //Internal server error
@@ -392,14 +388,15 @@ namespace webRoute
 
         uint64_t currentQuantity, removedQuantity = 1;
         {
-            const auto result = std::from_chars(searchResult[0][0].data(), searchResult[0][0].data() + searchResult[0][0].size(), currentQuantity);
-            if (result.ec != std::errc())
+            const auto result = searchResult.getInteger(0, 0);
+            if (!result.has_value())
             {
                 //Internal server error
                 res->writeStatus(HTTPCodes::INTERNALERROR);
                 res->end();
                 return;
             }
+            currentQuantity = result.value();
         }
         if (b.hasElement("quantity"))
         {
@@ -422,37 +419,39 @@ namespace webRoute
             return;
         }
 
-        if (removedQuantity >= currentQuantity)
+        const bool removesAll = removedQuantity >= currentQuantity;
+        const auto [status, result] = removesAll ?
+            serverData::database->query("DELETE FROM " + serverData::tableNames[serverData::PARTSINSERVICE] + " WHERE ID = :ID", { {":ID", asInteger(b.getElement("entry"))} }) :
+            serverData::database->query("UPDATE " + serverData::tableNames[serverData::PARTSINSERVICE] + " SET QUANTITY = QUANTITY - :QNT WHERE ID = :ID",
+                { {":QNT", static_cast<int64_t>(removedQuantity)}, {":ID", asInteger(b.getElement("entry"))} });
+        if (!status)
         {
-            const auto [status, result] = serverData::database->query("DELETE FROM " + serverData::tableNames[serverData::PARTSINSERVICE] + " WHERE ID = :ID", { {":ID", b.getElement("entry")} });
-            if (!status)
-            {
-                //Internal server error
-                res->writeStatus(HTTPCodes::INTERNALERROR);
-            }
-            else
-            {
-                std::cout << "Session (" << serverData::auth->getSessionID(req).value() << ") removed a set of existing parts from a service.\n";
-            }
+            //Internal server error
+            res->writeStatus(HTTPCodes::INTERNALERROR);
             res->end();
             return;
-
+        }
+        //Only the parts actually taken out of the service come off its total
+        const auto [totalStatus, totalResult] = adjustServiceTotal(asInteger(searchResult[0][1]), asInteger(searchResult[0][2]), -static_cast<int64_t>(removesAll ? currentQuantity : removedQuantity));
+        if (totalStatus && totalResult.rowCount() == 0)
+        {
+            //Conflict - The service is closed, the removal is rolled back with the transaction
+            res->writeStatus(HTTPCodes::CONFLICT);
+        }
+        else if (!totalStatus || !transaction.commit())
+        {
+            //Internal server error
+            res->writeStatus(HTTPCodes::INTERNALERROR);
+        }
+        else if (removesAll)
+        {
+            std::cout << "Session (" << serverData::auth->getSessionID(req).value() << ") removed a set of existing parts from a service.\n";
         }
         else
         {
-            const auto [status, result] = serverData::database->query("UPDATE " + serverData::tableNames[serverData::PARTSINSERVICE] + " SET QUANTITY = QUANTITY - :QNT WHERE ID = :ID",
-                { {":QNT", b.hasElement("quantity") ? b.getElement("quantity") : "1"}, {":ID", b.getElement("entry")} });
-            if (!status)
-            {
-                //Internal server error
-                res->writeStatus(HTTPCodes::INTERNALERROR);
-            }
-            else
-            {
-                std::cout << "Session (" << serverData::auth->getSessionID(req).value() << ") removed some existing parts from a service.\n";
-            }
-            res->end();
+            std::cout << "Session (" << serverData::auth->getSessionID(req).value() << ") removed some existing parts from a service.\n";
         }
+        res->end();
     }
 
     void searchServices(uWS::HttpResponse<true>* res, uWS::HttpRequest* req, const body& b, const query& q)
@@ -483,183 +482,230 @@ namespace webRoute
             res->end();
             return;
         }
-        responseWrapper response;
-
-        const std::unordered_map<std::string_view, std::string_view> userID =
-            q.hasElement("UID") ? std::unordered_map<std::string_view, std::string_view>{ {":ID", q.getElement("UID")}} : std::unordered_map<std::string_view, std::string_view>{};
-
-        if (q.hasElement("unauthorised", true))
+        const auto page = pageRequest::fromQuery(q);
+        const auto after = page.has_value() ? page->afterID() : std::nullopt;
+        if (!after.has_value())
         {
-            const auto [status, result] = serverData::database->query(
-                "SELECT SERVICE, V.ID, V.OWNER, SS.REQUEST, SS.REQUESTED FROM " + serverData::tableNames[serverData::SERVICEUNAUTHORISED] + 
-                " INNER JOIN " + serverData::tableNames[serverData::SERVICESHARED] + " AS SS ON SERVICE = SS.ID" +
-                " INNER JOIN " + serverData::tableNames[serverData::VEHICLES] + " AS V ON SS.VEHICLE = V.ID" +
-                " INNER JOIN " + serverData::tableNames[serverData::USER] + " AS U ON U.ID = V.OWNER" + (q.hasElement("UID") ? " WHERE U.ID = :ID" : ""), userID);
-            if (!status)
+            //Bad Request - Invalid arguments
+            res->writeStatus(HTTPCodes::BADREQUEST);
+            res->end();
+            return;
+        }
+        //The search runs on a database thread, leaving the network loop free for other requests
+        serverData::executor->submit(res, [q, page = page.value(), after = after.value()](sqlite3DB& reader) -> routeResult
             {
-                //Internal server error
-                res->writeStatus(HTTPCodes::INTERNALERROR);
-                res->end();
-                return;
-            }
+                responseWrapper response;
 
+                SQLParams params{ {":AFT", after}, {":LIM", page.readLimit()} };
+                if (q.hasElement("UID"))
+                    params.add({ ":ID", asInteger(q.getElement("UID")) });
 
-            for (size_t i = 0; i < result.rowCount(); i++)
-            {
-                responseWrapper temp;
-                temp.add("service", result[i][0]);
-                temp.add("vehicle", result[i][1]);
-                temp.add("owner", result[i][2]);
-                temp.add("request", result[i][3]);
-                temp.add("requested", result[i][4]);
-                response.add("Unauthorised", std::move(temp), true);
-            }
-        }
+                //Every list is paged by service ID, each is read one service past the limit so the page can be cut across all of them
+                const std::string inPage = " AND S.ID >= :AFT ORDER BY S.ID LIMIT :LIM";
+                const std::string ownedBy = q.hasElement("UID") ? " AND V.OWNER = :ID" : "";
 
-        if (q.hasElement("open", true))
-        {
-            const auto [status, result] = serverData::database->query(
-                "SELECT S.ID, S.VEHICLE, V.OWNER, S.REQUEST, S.REQUESTED, A.LABOUR, A.NOTES, U.ID, A.QUOTE, S.ID FROM " + serverData::tableNames[serverData::SERVICEOPEN] + " AS SO" +
-                " INNER JOIN " + serverData::tableNames[serverData::SERVICEACTIVE] + " AS A ON SO.SERVICE = A.ID" +
-                " INNER JOIN " + serverData::tableNames[serverData::SERVICESHARED] + " AS S ON A.SERVICE = S.ID" +
-                " INNER JOIN " + serverData::tableNames[serverData::VEHICLES] + " AS V ON S.VEHICLE = V.ID" +
-                " INNER JOIN " + serverData::tableNames[serverData::USER] + " AS U ON A.AUTHORISER = U.ID" +
-                " INNER JOIN " + serverData::tableNames[serverData::USER] + " AS O ON V.OWNER = O.ID" + (q.hasElement("UID") ? " WHERE O.ID = :ID" : ""), userID);
-            if (!status)
-            {
-                //Internal server error
-                res->writeStatus(HTTPCodes::INTERNALERROR);
-                res->end();
-                return;
-            }
+                std::optional<SQLResult> unauthorised, open, openParts, closed, closedParts;
 
-            for (size_t i = 0; i < result.rowCount(); i++)
-            {
-                responseWrapper temp;
-                temp.add("service", result[i][0]);
-                temp.add("vehicle", result[i][1]);
-                temp.add("owner", result[i][2]);
-                temp.add("request", result[i][3]);
-                temp.add("requested", result[i][4]);
-                temp.add("labour", result[i][5]);
-                temp.add("notes", result[i][6]);
-                temp.add("authoriser", result[i][7]);
-                temp.add("quote", result[i][8]);
+                if (q.hasElement("unauthorised", true))
+                {
+                    auto [status, result] = reader.query(
+                        "SELECT S.ID, V.ID, V.OWNER, S.REQUEST, S.REQUESTED FROM " + serverData::tableNames[serverData::SERVICES] + " AS S" +
+                        " INNER JOIN " + serverData::tableNames[serverData::VEHICLES] + " AS V ON S.VEHICLE = V.ID" +
+                        " WHERE S.STATUS = 'unauthorised'" + ownedBy + inPage, params);
+                    if (!status)
+                    {
+                        //Internal server error
+                        return { HTTPCodes::INTERNALERROR };
+                    }
+                    unauthorised = std::move(result);
+                }
 
+                if (q.hasElement("open", true))
                 {
-                    const auto [partStatus, partResult] = serverData::database->query(
-                        "SELECT PS.ID, P.NAME, PS.PART, PS.QUANTITY, P.PRICE FROM " + serverData::tableNames[serverData::PARTSINSERVICE] + " AS PS" +
+                    const std::string openServices = " FROM " + serverData::tableNames[serverData::SERVICES] + " AS S" +
+                        " INNER JOIN " + serverData::tableNames[serverData::VEHICLES] + " AS V ON S.VEHICLE = V.ID" +
+                        " WHERE S.STATUS = 'open'" + ownedBy + inPage;
+
+                    auto [status, result] = reader.query(
+                        "SELECT S.ID, S.VEHICLE, V.OWNER, S.REQUEST, S.REQUESTED, S.LABOUR, S.NOTES, S.AUTHORISER, S.QUOTE, S.TOTAL, S.PARTCOUNT" + openServices, params);
+                    if (!status)
+                    {
+                        //Internal server error
+                        return { HTTPCodes::INTERNALERROR };
+                    }
+                    open = std::move(result);
+
+                    //The parts of every service found are read together, rather than with a query per service
+                    auto [partStatus, partResult] = reader.query(
+                        "SELECT PS.SERVICE, PS.ID, P.NAME, PS.PART, PS.QUANTITY, P.PRICE FROM " + serverData::tableNames[serverData::PARTSINSERVICE] + " AS PS" +
                         " INNER JOIN " + serverData::tableNames[serverData::PARTS] + " AS P ON PS.PART = P.ID" +
-                        " WHERE PS.SERVICE = :ID",
-                        { {":ID", result[i][9] } });
+                        " WHERE PS.SERVICE IN (SELECT S.ID" + openServices + ")", params);
                     if (!partStatus)
                     {
-                        res->writeStatus(HTTPCodes::INTERNALERROR);
-                        res->end();
-                        return;
+                        //Internal server error
+                        return { HTTPCodes::INTERNALERROR };
+                    }
+                    openParts = std::move(partResult);
+                }
+
+                if (q.hasElement("closed", true))
+                {
+                    const std::string closedServices = " FROM " + serverData::tableNames[serverData::SERVICES] + " AS S " +
+                        "INNER JOIN " + serverData::tableNames[serverData::VEHICLES] + " AS V ON S.VEHICLE = V.ID " +
+                        "WHERE S.STATUS = 'closed'" + ownedBy + inPage;
+
+                    auto [status, result] = reader.query(
+                        "SELECT S.ID, S.VEHICLE, V.OWNER, S.REQUEST, S.REQUESTED, S.LABOUR, S.NOTES, S.AUTHORISER, S.QUOTE, S.COMPLETED, S.COMPLETER, S.PAID, S.TOTAL, S.PARTCOUNT" + closedServices, params);
+                    if (!status)
+                    {
+                        //Internal server error
+                        return { HTTPCodes::INTERNALERROR };
+                    }
+                    closed = std::move(result);
+
+                    //The parts of every service found are read together, rather than with a query per service
+                    auto [partStatus, partResult] = reader.query(
+                        "SELECT PS.SERVICE, P.NAME, PS.PART, PS.QUANTITY, P.PRICE FROM " + serverData::tableNames[serverData::PARTSINSERVICE] + " AS PS "
+                        "INNER JOIN " + serverData::tableNames[serverData::PARTS] + " AS P ON PS.PART = P.ID WHERE PS.SERVICE IN (SELECT S.ID" + closedServices + ")", params);
+                    if (!partStatus)
+                    {
+                        //Internal server error
+                        return { HTTPCodes::INTERNALERROR };
+                    }
+                    closedParts = std::move(partResult);
+                }
+
+                //The page holds the first services of all the lists together, the last of which is the cursor of the next page
+                //Every list was read past the limit, so none can be missing a service that belongs on this page
+                int64_t last = std::numeric_limits<int64_t>::max();
+                {
+                    std::vector<int64_t> IDs;
+                    for (const auto* list : { &unauthorised, &open, &closed })
+                    {
+                        for (size_t i = 0; list->has_value() && i < (*list)->rowCount(); i++)
+                            IDs.push_back((*list)->getInteger(i, 0).value_or(0));
+                    }
+                    const size_t limit = static_cast<size_t>(page.getLimit());
+                    if (IDs.size() > limit)
+                    {
+                        std::nth_element(IDs.begin(), IDs.begin() + (limit - 1), IDs.end());
+                        last = IDs[limit - 1];
+                    }
+                }
+                //Lists are in ID order, so the rest of a list is left for the next page once it passes the last service
+                const auto onPage = [last](const SQLResult& result, size_t row)
+                {
+                    return result.getInteger(row, 0).value_or(0) <= last;
+                };
+
+                if (unauthorised.has_value())
+                {
+                    const SQLResult& result = *unauthorised;
+                    for (size_t i = 0; i < result.rowCount() && onPage(result, i); i++)
+                    {
+                        responseWrapper temp;
+                        temp.add("service", result[i][0]);
+                        temp.add("vehicle", result[i][1]);
+                        temp.add("owner", result[i][2]);
+                        temp.add("request", result[i][3]);
+                        temp.add("requested", result[i][4]);
+                        response.add("Unauthorised", std::move(temp), true);
                     }
+                }
 
-                    double totalPrice = 0;
+                if (open.has_value())
+                {
+                    const SQLResult& result = *open;
+                    const SQLResult& partResult = *openParts;
+                    const auto parts = groupByService(partResult, 0);
+                    if (!parts.has_value())
+                    {
+                        return { HTTPCodes::INTERNALERROR };
+                    }
 
-                    for (size_t i = 0; i < partResult.rowCount(); i++)
+                    for (size_t i = 0; i < result.rowCount() && onPage(result, i); i++)
                     {
-                        responseWrapper temp2;
-                        temp2.add("entry", partResult[i][0]);
-                        temp2.add("name", partResult[i][1]);
-                        temp2.add("ID", partResult[i][2]);
-                        temp2.add("quantity", partResult[i][3]);
-                        temp2.add("price", partResult[i][4]);
+                        responseWrapper temp;
+                        temp.add("service", result[i][0]);
+                        temp.add("vehicle", result[i][1]);
+                        temp.add("owner", result[i][2]);
+                        temp.add("request", result[i][3]);
+                        temp.add("requested", result[i][4]);
+                        temp.add("labour", result[i][5]);
+                        temp.add("notes", result[i][6]);
+                        temp.add("authoriser", result[i][7]);
+                        temp.add("quote", result[i][8]);
+
                         {
-                            const auto price = getPartPrice(partResult[i][4], partResult[i][3]);
-                            if (!price.has_value())
+                            const auto service = parts->find(result.getInteger(i, 0).value_or(-1));
+                            const std::vector<size_t> none;
+                            for (const size_t row : service == parts->end() ? none : service->second)
                             {
-                                res->writeStatus(HTTPCodes::INTERNALERROR);
-                                res->end();
-                                return;
+                                responseWrapper temp2;
+                                temp2.add("entry", partResult[row][1]);
+                                temp2.add("name", partResult[row][2]);
+                                temp2.add("ID", partResult[row][3]);
+                                temp2.add("quantity", partResult[row][4]);
+                                temp2.add("price", partResult[row][5]);
+                                temp.add("parts", std::move(temp2), true);
                             }
-                            totalPrice += price.value();
+                            temp.add("total", result[i][9]);
+                            temp.add("partCount", result[i][10]);
                         }
-                        temp.add("parts", std::move(temp2), true);
+
+                        response.add("Open", std::move(temp), true);
                     }
-                    temp.add("total", std::to_string(totalPrice));
                 }
 
-                response.add("Open", std::move(temp), true);
-            }
-        }
-
-        if (q.hasElement("closed", true))
-        {
-            const auto [status, result] = serverData::database->query(
-                "SELECT S.ID, S.VEHICLE, V.OWNER, S.REQUEST, S.REQUESTED, A.LABOUR, A.NOTES, A.AUTHORISER, A.QUOTE, C.COMPLETED, C.COMPLETER, C.PAID FROM " 
-                + serverData::tableNames[serverData::SERVICECLOSED] + " AS C "
-                "INNER JOIN " + serverData::tableNames[serverData::SERVICEACTIVE] + " AS A ON C.SERVICE = A.ID " +
-                "INNER JOIN " + serverData::tableNames[serverData::SERVICESHARED] + " AS S ON A.SERVICE = S.ID " +
-                "INNER JOIN " + serverData::tableNames[serverData::VEHICLES] + " AS V ON S.VEHICLE = V.ID " +
-                "INNER JOIN " + serverData::tableNames[serverData::USER] + " AS O ON V.OWNER = O.ID" + (q.hasElement("UID") ? " WHERE O.ID = :ID" : ""), userID);
-            if (!status)
-            {
-                //Internal server error
-                res->writeStatus(HTTPCodes::INTERNALERROR);
-                res->end();
-                return;
-            }
-
-            for (size_t i = 0; i < result.rowCount(); i++)
-            {
-                responseWrapper temp;
-                temp.add("service", result[i][0]);
-                temp.add("vehicle", result[i][1]);
-                temp.add("owner", result[i][2]);
-                temp.add("request", result[i][3]);
-                temp.add("requested", result[i][4]);
-                temp.add("labour", result[i][5]);
-                temp.add("notes", result[i][6]);
-                temp.add("authoriser", result[i][7]);
-                temp.add("quote", result[i][8]);
-                temp.add("completed", result[i][9]);
-                temp.add("completer", result[i][10]);
-                temp.add("paid", result[i][11]);
-
+                if (closed.has_value())
                 {
-                    const auto [partStatus, partResult] = serverData::database->query(
-                        "SELECT P.NAME, PS.PART, PS.QUANTITY, P.PRICE FROM " + serverData::tableNames[serverData::PARTSINSERVICE] + " AS PS "
-                        "INNER JOIN " + serverData::tableNames[serverData::PARTS] + " AS P ON PS.PART = P.ID WHERE PS.SERVICE = :ID",
-                        { {":ID", result[i][0] } });
-                    if (!partStatus)
+                    const SQLResult& result = *closed;
+                    const SQLResult& partResult = *closedParts;
+                    const auto parts = groupByService(partResult, 0);
+                    if (!parts.has_value())
                     {
-                        res->writeStatus(HTTPCodes::INTERNALERROR);
-                        res->end();
-                        return;
+                        return { HTTPCodes::INTERNALERROR };
                     }
-                    double totalPrice = 0;
-                    for (size_t i = 0; i < partResult.rowCount(); i++)
+
+                    for (size_t i = 0; i < result.rowCount() && onPage(result, i); i++)
                     {
-                        responseWrapper temp2;
-                        temp2.add("name", partResult[i][0]);
-                        temp2.add("ID", partResult[i][1]);
-                        temp2.add("quantity", partResult[i][2]);
-                        temp2.add("price", partResult[i][3]);
+                        responseWrapper temp;
+                        temp.add("service", result[i][0]);
+                        temp.add("vehicle", result[i][1]);
+                        temp.add("owner", result[i][2]);
+                        temp.add("request", result[i][3]);
+                        temp.add("requested", result[i][4]);
+                        temp.add("labour", result[i][5]);
+                        temp.add("notes", result[i][6]);
+                        temp.add("authoriser", result[i][7]);
+                        temp.add("quote", result[i][8]);
+                        temp.add("completed", result[i][9]);
+                        temp.add("completer", result[i][10]);
+                        temp.add("paid", result[i][11]);
+
                         {
-                            const auto price = getPartPrice(partResult[i][3], partResult[i][2]);
-                            if (!price.has_value())
+                            const auto service = parts->find(result.getInteger(i, 0).value_or(-1));
+                            const std::vector<size_t> none;
+                            for (const size_t row : service == parts->end() ? none : service->second)
                             {
-                                res->writeStatus(HTTPCodes::INTERNALERROR);
-                                res->end();
-                                return;
+                                responseWrapper temp2;
+                                temp2.add("name", partResult[row][1]);
+                                temp2.add("ID", partResult[row][2]);
+                                temp2.add("quantity", partResult[row][3]);
+                                temp2.add("price", partResult[row][4]);
+                                temp.add("parts", std::move(temp2), true);
                             }
-                            totalPrice += price.value();
+                            temp.add("total", result[i][12]);
+                            temp.add("partCount", result[i][13]);
                         }
-                        temp.add("parts", std::move(temp2), true);
+
+                        response.add("Closed", std::move(temp), true);
                     }
-                    temp.add("total", std::to_string(totalPrice));
                 }
 
-                response.add("Closed", std::move(temp), true);
-            }
-        }
-
-        res->tryEnd(response.toData(false));
+                response.add("next", last == std::numeric_limits<int64_t>::max() ? "" : std::to_string(last));
+                return { HTTPCodes::OK, response.toData(false) };
+            });
     }
 
 
@@ -679,237 +725,141 @@ namespace webRoute
             res->end();
             return;
         }
-        if (!serverData::auth->verify(req, authLevel::employee))
-        {
-            {
-
-                const auto [status, result] = serverData::database->query("SELECT U.ID FROM " + serverData::tableNames[serverData::VEHICLES] + " AS V " +
-                    "INNER JOIN " + serverData::tableNames[serverData::USER] + " AS V ON V.OWNER = U.ID " +
-                    "INNER JOIN " + serverData::tableNames[serverData::SERVICESHARED] + " AS S ON S.VEHICLE = V.ID WHERE S.ID = :ID", { {":ID", q.getElement("ID")} });
-                if (!status || result.rowCount() == 0)
-                {
-                    //Internal server error
-                    res->writeStatus(HTTPCodes::INTERNALERROR);
-                    res->end();
-                    return;
-                }
-
-                const auto UID = serverData::auth->getSessionUser(req);
-                if (!UID.has_value() || std::to_string(UID.value()) != result[0][0])
-                {
-                    //Forbidden - Insufficient permissions
-                    res->writeStatus(HTTPCodes::FORBIDDEN);
-                    res->end();
-                    return;
-                }
-            }
-        }
-        responseWrapper response;
-
-        //Collect all common data first
-
-        //Service Status - This is determined by which tables the request is present in
-
-        //Service ID
-        //Vehicle ID
-        //Owner ID
-        //Original Request
-        //Time Requested
-
         {
-            const auto [status, result] = serverData::database->query(
-                "SELECT S.ID, V.ID, U.ID, S.REQUEST, S.REQUESTED FROM " + serverData::tableNames[serverData::SERVICESHARED] + " AS S " +
-                "INNER JOIN " + serverData::tableNames[serverData::VEHICLES] + " AS V ON V.ID = S.VEHICLE " +
-                "INNER JOIN " + serverData::tableNames[serverData::USER] + " AS U ON U.ID = V.OWNER " +
-                "WHERE S.ID = :ID", { {":ID", q.getElement("ID")} });
-
-            if (!status)
-            {
-                res->writeStatus(HTTPCodes::INTERNALERROR);
-                res->end();
-                return;
-            }
-            if (result.rowCount() == 0)
+            const auto owner = serverData::owners->serviceOwner(q.getElement("ID"));
+            if (!owner.has_value())
             {
+                //Not found - No service with that ID
                 res->writeStatus(HTTPCodes::NOTFOUND);
                 res->end();
                 return;
             }
-
-            response.add("service", result[0][0]);
-            response.add("vehicle", result[0][1]);
-            response.add("owner", result[0][2]);
-            response.add("request", result[0][3]);
-            response.add("requested", result[0][4]);
-        }
-
-        //Check if in unauthorised list
-        {
-            const auto [status, result] = serverData::database->query(
-                "SELECT U.ID FROM " + serverData::tableNames[serverData::SERVICEUNAUTHORISED] + " AS U "
-                "INNER JOIN " + serverData::tableNames[serverData::SERVICESHARED] + " AS S ON S.ID = U.SERVICE WHERE S.ID = :ID",
-                { {":ID", q.getElement("ID")} });
-            if (!status)
+            //Other users may only see services for their own vehicles
+            if (!serverData::auth->isSessionUser(req, owner) && !serverData::auth->verify(req, authLevel::employee))
             {
-                res->writeStatus(HTTPCodes::INTERNALERROR);
+                //Forbidden - Insufficient permissions
+                res->writeStatus(HTTPCodes::FORBIDDEN);
                 res->end();
                 return;
             }
-            if (result.rowCount() != 0)
-            {
-                response.add("status", "unauthorised");
-                res->tryEnd(response.toData(false));
-                return;
-            }
         }
 
-        //If the service is authorised (including all previous data)
-
-        //The authoriser
-        //Current labour hours
-        //Current part list
-        //Employee notes
-        //Quoted Price
-
-        {
-            //Find active data
-            {
-                const auto [status, result] = serverData::database->query(
-                    "SELECT A.LABOUR, A.NOTES, A.AUTHORISER, A.QUOTE FROM " + serverData::tableNames[serverData::SERVICEACTIVE] + + " AS A"
-                    " WHERE A.SERVICE = :ID", { {":ID", q.getElement("ID")} });
-                if (!status || result.rowCount() == 0)
-                {
-                    res->writeStatus(HTTPCodes::INTERNALERROR);
-                    res->end();
-                    return;
-                }
-                response.add("labour", result[0][0]);
-                response.add("notes", result[0][1]);
-                response.add("authoriser", result[0][2]);
-                response.add("quote", result[0][3]);
-            }
+        //Only once the session may see the service is an unchanged copy confirmed
+        const entityTag tag("/service/select", req->getQuery(), { serverData::SERVICES, serverData::VEHICLES, serverData::PARTSINSERVICE, serverData::PARTS });
+        if (tag.answer(res, req))
+            return;
 
-            //Find any parts
+        //The lookups run on a database thread, leaving the network loop free for other requests
+        serverData::executor->submit(res, [q, tag = tag.value()](sqlite3DB& reader) -> routeResult
             {
-                const auto [status, result] = serverData::database->query(
-                    "SELECT P.NAME, PS.PART, PS.QUANTITY, P.PRICE FROM " + serverData::tableNames[serverData::PARTSINSERVICE] + " AS PS" +
-                    " INNER JOIN " + serverData::tableNames[serverData::PARTS] + " AS P ON PS.PART = P.ID" +
-                    " INNER JOIN " + serverData::tableNames[serverData::SERVICESHARED] + " AS S ON PS.SERVICE = S.ID WHERE S.ID = :ID",
-                    { {":ID", q.getElement("ID") } });
-                if (!status)
-                {
-                    res->writeStatus(HTTPCodes::INTERNALERROR);
-                    res->end();
-                    return;
-                }
-
-                double totalPrice = 0;
-
-                for (size_t i = 0; i < result.rowCount(); i++)
-                {
-                    responseWrapper temp;
-                    temp.add("name", result[i][0]);
-                    temp.add("ID", result[i][1]);
-                    temp.add("quantity", result[i][2]);
-                    temp.add("price", result[i][3]);
-                    {
-                        const auto price = getPartPrice(result[i][3], result[i][2]);
-                        if (!price.has_value())
-                        {
-                            res->writeStatus(HTTPCodes::INTERNALERROR);
-                            res->end();
-                            return;
-                        }
-                        totalPrice += price.value();
-                    }
-                    response.add("parts", std::move(temp), true);
-                }
-                response.add("total", std::to_string(totalPrice));
-            }
+                //Every field and the service's status are found in one query
+                //Unauthorised services only have the request, the authorisation fields are set once authorised, and the closing fields once closed
+                const auto [status, result] = reader.query(
+                    "SELECT S.ID, V.ID, V.OWNER, S.REQUEST, S.REQUESTED, S.STATUS, "
+                    "S.LABOUR, S.NOTES, S.AUTHORISER, S.QUOTE, S.COMPLETER, S.COMPLETED, S.PAID, S.TOTAL, S.PARTCOUNT FROM " + serverData::tableNames[serverData::SERVICES] + " AS S " +
+                    "INNER JOIN " + serverData::tableNames[serverData::VEHICLES] + " AS V ON V.ID = S.VEHICLE " +
+                    "WHERE S.ID = :ID", { {":ID", asInteger(q.getElement("ID"))} });
 
-            //Check if this service is still open
-            {
-                const auto [status, result] = serverData::database->query(
-                    "SELECT ID FROM " + serverData::tableNames[serverData::SERVICEOPEN] + " WHERE SERVICE = :ID",
-                    { {":ID", q.getElement("ID")} });
                 if (!status)
                 {
-                    res->writeStatus(HTTPCodes::INTERNALERROR);
-                    res->end();
-                    return;
+                    return { HTTPCodes::INTERNALERROR };
                 }
-                if (result.rowCount() != 0)
+                if (result.rowCount() == 0)
                 {
-                    response.add("status", "authorised");
-                    res->tryEnd(response.toData(false));
-                    return;
+                    return { HTTPCodes::NOTFOUND };
                 }
-            }
-        }
 
-        //If the service is closed (including all previous data)
+                const std::string_view serviceStatus = result[0][5];
 
-        //Warrantied parts
-        //Service Completer
-        //Date Completed
-        //Price Paid
+                responseWrapper response;
 
-        {
-            const auto [status, result] = serverData::database->query(
-                "SELECT C.ID, C.COMPLETED, C.PAID FROM " + serverData::tableNames[serverData::SERVICECLOSED] + " AS C " +
-                "INNER JOIN " + serverData::tableNames[serverData::SERVICESHARED] + " AS S ON SERVICE = S.ID " +
-                "WHERE S.ID + :ID", { {":ID", q.getElement("ID")} });
+                //Service ID
+                //Vehicle ID
+                //Owner ID
+                //Original Request
+                //Time Requested
+                response.add("service", result[0][0]);
+                response.add("vehicle", result[0][1]);
+                response.add("owner", result[0][2]);
+                response.add("request", result[0][3]);
+                response.add("requested", result[0][4]);
 
-            if (!status || result.rowCount() == 0)
-            {
-                res->writeStatus(HTTPCodes::INTERNALERROR);
-                res->end();
-                return;
-            }
-
-            response.add("completer", result[0][0]);
-            response.add("completed", result[0][1]);
-            response.add("paid", result[0][2]);
-
-            //Find warrantied parts
-            {
-                const auto [lds, ldr] = serverData::database->query("SELECT DATE(:DAT, '-6 month')", { {":DAT", result[0][1]} });
-                if (!lds)
+                if (serviceStatus == "unauthorised")
                 {
-                    res->writeStatus(HTTPCodes::INTERNALERROR);
-                    res->end();
-                    return;
+                    response.add("status", serviceStatus);
+                    return { HTTPCodes::OK, response.toData(false), tag };
                 }
 
-                const auto [partStatus, partResult] = serverData::database->query(
-                    "SELECT P.NAME, PS.PART, PS.QUANTITY FROM " + serverData::tableNames[serverData::SERVICECLOSED] + " AS S " +
-                    "INNER JOIN " + serverData::tableNames[serverData::SERVICEACTIVE] + " AS A ON S.SERVICE = A.ID " +
-                    "INNER JOIN " + serverData::tableNames[serverData::SERVICESHARED] + " AS SS ON A.SERVICE = SS.ID " +
-                    "INNER JOIN " + serverData::tableNames[serverData::PARTSINSERVICE] + " AS PS ON SS.ID = PS.SERVICE " +
-                    "INNER JOIN " + serverData::tableNames[serverData::PARTS] + " AS P ON PS.PART = P.ID " +
-                    "WHERE S.ID != :ID AND S.COMPLETED >= :LOWDATE AND S.COMPLETED <= :HIGHDATE",
-                    { {":ID", q.getElement("ID")}, {":LOWDATE", ldr[0][0]}, {":HIGHDATE", result[0][1]} });
+                //If the service is authorised (including all previous data)
+
+                //The authoriser
+                //Current labour hours
+                //Current part list
+                //Employee notes
+                //Quoted Price
+                response.add("labour", result[0][6]);
+                response.add("notes", result[0][7]);
+                response.add("authoriser", result[0][8]);
+                response.add("quote", result[0][9]);
+
+                //The service's parts, and for a closed service the parts fitted by other services closed in the six months before it (warrantied), are read together
+                const bool closed = serviceStatus == "closed";
+                std::string partSQL =
+                    "SELECT 0, P.NAME, PS.PART, PS.QUANTITY, P.PRICE FROM " + serverData::tableNames[serverData::PARTSINSERVICE] + " AS PS" +
+                    " INNER JOIN " + serverData::tableNames[serverData::PARTS] + " AS P ON PS.PART = P.ID WHERE PS.SERVICE = :ID";
+                SQLParams partParams{ {":ID", asInteger(q.getElement("ID"))} };
+                if (closed)
+                {
+                    partSQL += " UNION ALL SELECT 1, P.NAME, PS.PART, PS.QUANTITY, P.PRICE FROM " + serverData::tableNames[serverData::SERVICES] + " AS C " +
+                        "INNER JOIN " + serverData::tableNames[serverData::PARTSINSERVICE] + " AS PS ON C.ID = PS.SERVICE " +
+                        "INNER JOIN " + serverData::tableNames[serverData::PARTS] + " AS P ON PS.PART = P.ID " +
+                        "WHERE C.STATUS = 'closed' AND C.ID != :ID AND C.COMPLETED >= DATE(:DAT, '-6 month') AND C.COMPLETED <= :DAT";
+                    partParams.add({ ":DAT", result[0][11] });
+                }
 
+                const auto [partStatus, partResult] = reader.query(partSQL, partParams);
                 if (!partStatus)
                 {
-                    res->writeStatus(HTTPCodes::INTERNALERROR);
-                    res->end();
-                    return;
+                    return { HTTPCodes::INTERNALERROR };
                 }
 
                 for (size_t i = 0; i < partResult.rowCount(); i++)
                 {
                     responseWrapper temp;
-                    temp.add("name", partResult[i][0]);
-                    temp.add("ID", partResult[i][1]);
-                    temp.add("quantity", partResult[i][2]);
-                    response.add("warrantied", std::move(temp), true);
+                    temp.add("name", partResult[i][1]);
+                    temp.add("ID", partResult[i][2]);
+                    temp.add("quantity", partResult[i][3]);
+                    if (partResult.getInteger(i, 0) == 1)
+                    {
+                        response.add("warrantied", std::move(temp), true);
+                        continue;
+                    }
+
+                    temp.add("price", partResult[i][4]);
+                    response.add("parts", std::move(temp), true);
                 }
-            }
+                response.add("total", result[0][13]);
+                response.add("partCount", result[0][14]);
 
-            res->tryEnd(response.toData(false));
-            return;
-        }
+                if (!closed)
+                {
+                    //Open services are reported as authorised
+                    response.add("status", "authorised");
+                    return { HTTPCodes::OK, response.toData(false), tag };
+                }
+
+                //If the service is closed (including all previous data)
+
+                //Warrantied parts
+                //Service Completer
+                //Date Completed
+                //Price Paid
+                response.add("status", serviceStatus);
+                response.add("completer", result[0][10]);
+                response.add("completed", result[0][11]);
+                response.add("paid", result[0][12]);
+                return { HTTPCodes::OK, response.toData(false), tag };
+            });
     }
 
 
@@ -941,30 +891,30 @@ namespace webRoute
             res->end();
             return;
         }
-        responseWrapper response;
+        //The lookup runs on a database thread, in parallel with other reads
+        serverData::executor->submit(res, [q](sqlite3DB& reader) -> routeResult
+            {
+                responseWrapper response;
 
-        const auto [status, result] = serverData::database->query(
-            "SELECT ID, SERVICE, PART, QUANTITY FROM " + serverData::tableNames[serverData::PARTSINSERVICE] +
-            " WHERE ID = :ID", { {":ID", q.getElement("entry")} });
+                const auto [status, result] = reader.query(
+                    "SELECT ID, SERVICE, PART, QUANTITY FROM " + serverData::tableNames[serverData::PARTSINSERVICE] +
+                    " WHERE ID = :ID", { {":ID", asInteger(q.getElement("entry"))} });
 
-        if (!status)
-        {
-            res->writeStatus(HTTPCodes::INTERNALERROR);
-            res->end();
-            return;
-        }
-        if (result.rowCount() == 0)
-        {
-            res->writeStatus(HTTPCodes::NOTFOUND);
-            res->end();
-            return;
-        }
+                if (!status)
+                {
+                    return { HTTPCodes::INTERNALERROR };
+                }
+                if (result.rowCount() == 0)
+                {
+                    return { HTTPCodes::NOTFOUND };
+                }
 
-        response.add("entry", result[0][0]);
-        response.add("serviceID", result[0][1]);
-        response.add("partID", result[0][2]);
-        response.add("quantity", result[0][3]);
+                response.add("entry", result[0][0]);
+                response.add("serviceID", result[0][1]);
+                response.add("partID", result[0][2]);
+                response.add("quantity", result[0][3]);
 
-        res->tryEnd(response.toData(false));
+                return { HTTPCodes::OK, response.toData(false) };
+            });
     }
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 #pragma once
 #include "Network.h"
 #include "Response.h"
+#include "Executor.h"
+#include "VehicleModels.h"
 
 namespace webRoute
 {
@@ -38,7 +40,7 @@ namespace webRoute
         const auto [status, result] = serverData::database->query("INSERT INTO " + serverData::tableNames[serverData::USER] + " (ID, USERNAME, PASSWORD, PERMISSIONS) VALUES (NULL, :USR, :PAS, :PER);", {
                 {":USR", std::string(b.getElement("username"))},
                 {":PAS", std::string(b.getElement("password"))},
-                {":PER", std::string(b.getElement("permission"))} });
+                {":PER", asInteger(b.getElement("permission"))} });
 
         if (!status)
         {
@@ -65,48 +67,50 @@ namespace webRoute
             return;
         }
 
-        const auto [userStatus, userResult] = serverData::database->query("SELECT ID, USERNAME, PERMISSIONS FROM " + serverData::tableNames[serverData::USER] + " WHERE ID = :USR",
-            { {":USR", std::to_string(user.value())} });
-        if (!userStatus)
-        {          
-            //Internal Server Error
-            res->writeStatus(HTTPCodes::INTERNALERROR);
-            res->end();
-            return;
-        }
+        const auto sessionID = serverData::auth->getSessionID(req).value();
 
-        const auto [vehStatus, vehResult] = 
-            serverData::database->query(
-                "SELECT V.ID, V.PLATE, VS.MAKE, VS.MODEL, V.YEAR, V.COLOUR FROM " + serverData::tableNames[serverData::VEHICLES] + " AS V INNER JOIN " +
-                 serverData::tableNames[serverData::VEHICLESHARED] + " AS VS ON V.BASE = VS.ID WHERE V.OWNER = :USR;", { {":USR", std::to_string(user.value())} });
+        //The lookup runs on a database thread, in parallel with other reads
+        serverData::executor->submit(res, [user, sessionID](sqlite3DB& reader) -> routeResult
+            {
+                const auto [userStatus, userResult] = reader.query("SELECT ID, USERNAME, PERMISSIONS FROM " + serverData::tableNames[serverData::USER] + " WHERE ID = :USR",
+                    { {":USR", user.value()} });
+                if (!userStatus)
+                {          
+                    //Internal Server Error
+                    return { HTTPCodes::INTERNALERROR };
+                }
 
-        if (!vehStatus)
-        {
-            //Internal Server Error
-            res->writeStatus(HTTPCodes::INTERNALERROR);
-            res->end();
-            return;
-        }
+                const auto [vehStatus, vehResult] = 
+                    reader.query(
+                        "SELECT V.ID, V.PLATE, VS.MAKE, VS.MODEL, V.YEAR, V.COLOUR FROM " + serverData::tableNames[serverData::VEHICLES] + " AS V INNER JOIN " +
+                         serverData::tableNames[serverData::VEHICLESHARED] + " AS VS ON V.BASE = VS.ID WHERE V.OWNER = :USR;", { {":USR", user.value()} });
 
-        responseWrapper response;
-        response.add("ID", userResult[0][0]);
-        response.add("Username", userResult[0][1]);
-        response.add("Permissions", userResult[0][2]);
-        for (size_t i = 0; i < vehResult.rowCount(); i++)
-        {
-            responseWrapper temp;
-            temp.add("ID", vehResult[i][0]);
-            temp.add("Plate", vehResult[i][1]);
-            temp.add("Make", vehResult[i][2]);
-            temp.add("Model", vehResult[i][3]);
-            temp.add("Year", vehResult[i][4]);
-            temp.add("Colour", vehResult[i][5]);
-            response.add("Vehicles", std::move(temp), true);
-        }
+                if (!vehStatus)
+                {
+                    //Internal Server Error
+                    return { HTTPCodes::INTERNALERROR };
+                }
 
-        std::cout << "Session (" << serverData::auth->getSessionID(req).value() << ") accessed user data for (\"" << userResult[0][1] << "\").\n";
+                responseWrapper response;
+                response.add("ID", userResult[0][0]);
+                response.add("Username", userResult[0][1]);
+                response.add("Permissions", userResult[0][2]);
+                for (size_t i = 0; i < vehResult.rowCount(); i++)
+                {
+                    responseWrapper temp;
+                    temp.add("ID", vehResult[i][0]);
+                    temp.add("Plate", vehResult[i][1]);
+                    temp.add("Make", vehResult[i][2]);
+                    temp.add("Model", vehResult[i][3]);
+                    temp.add("Year", vehResult[i][4]);
+                    temp.add("Colour", vehResult[i][5]);
+                    response.add("Vehicles", std::move(temp), true);
+                }
+
+                std::cout << "Session (" << sessionID << ") accessed user data for (\"" << userResult[0][1] << "\").\n";
 
-        res->tryEnd(response.toData(false));
+                return { HTTPCodes::OK, response.toData(false) };
+            });
     }
 
     void searchUsers(uWS::HttpResponse<true>* res, uWS::HttpRequest* req, const body& b, const query& q)
@@ -127,60 +131,99 @@ namespace webRoute
             return;
         }
 
-        std::cout << "Session (" << serverData::auth->getSessionID(req).value() << ") searched for user (\"" << q.getElement("username") << "\").\n";
-
-        const auto [status, result] = serverData::database->query("SELECT ID, USERNAME, PERMISSIONS FROM " + serverData::tableNames[serverData::USER] + " WHERE USERNAME LIKE :USR ORDER BY USERNAME", 
-            { {":USR", generateLIKEArgument(q.getElement("username"))} });
-        if (!status)
+        const auto page = pageRequest::fromQuery(q);
+        if (!page.has_value())
         {
-            //Internal Server Error
-            res->writeStatus(HTTPCodes::INTERNALERROR);
+            //Bad Request - Invalid arguments
+            res->writeStatus(HTTPCodes::BADREQUEST);
             res->end();
             return;
         }
 
-        if (result.rowCount() != 0)
-        {
-            responseWrapper response;
-            for (size_t i = 0; i < result.rowCount(); i++)
+        std::cout << "Session (" << serverData::auth->getSessionID(req).value() << ") searched for user (\"" << q.getElement("username") << "\").\n";
+
+        //The search runs on a database thread, in parallel with other reads, sending users as they are found
+        serverData::executor->stream(res, [q, page = page.value()](sqlite3DB& reader, routeStream& stream) -> routeResult
             {
-                const auto [vehStatus, vehResult] =
-                    serverData::database->query(
-                        "SELECT V.PLATE, VS.MAKE, VS.MODEL, V.YEAR, V.COLOUR FROM VEHICLES AS V INNER JOIN VEHICLESHAREDDATA AS VS ON V.BASE = VS.ID WHERE V.OWNER = :USR;", { {":USR", result[i][0]} });
+                const auto& username = q.getElement("username");
+                //Longer names are found through the full text index, best matches first, rather than by scanning every user
+                const bool indexed = isTrigramSearchable(username);
+                const std::string argument = indexed ? generateMATCHArgument(username) : generateLIKEArgument(username);
+                std::string SQL = indexed ?
+                    "SELECT U.ID, U.USERNAME, U.PERMISSIONS, F.RANK FROM " + serverData::tableNames[serverData::USERSSEARCH] + " AS F" +
+                        " INNER JOIN " + serverData::tableNames[serverData::USER] + " AS U ON U.ID = F.ROWID" +
+                        " WHERE F." + serverData::tableNames[serverData::USERSSEARCH] + " MATCH :USR" :
+                    "SELECT ID, USERNAME, PERMISSIONS FROM " + serverData::tableNames[serverData::USER] + " WHERE USERNAME LIKE :USR";
+                SQLParams params{ {":USR", argument} };
+                //Unranked users are listed (and paged) alphabetically
+                if (!page.apply(SQL, params, indexed ? "U.ID" : "USERNAME", indexed))
+                {
+                    //Bad Request - Invalid arguments
+                    return { HTTPCodes::BADREQUEST };
+                }
+                auto cursor = reader.cursor(SQL, params);
 
-                if (!vehStatus)
+                //Rows are serialized as they are read, so nothing is sent until the first chunk is full
+                responseListWriter response("Users");
+                bool failed = false;
+                std::string last, next;
+                while (cursor.next())
                 {
+                    //The row past the limit only shows that another page follows
+                    if (static_cast<int64_t>(response.size()) == page.getLimit())
+                    {
+                        next = std::move(last);
+                        break;
+                    }
+                    last = indexed ? pageRequest::rankCursor(cursor.getReal(3).value_or(0), cursor.getInteger(0).value_or(0)) : std::string(cursor[1]);
+
+                    const auto [vehStatus, vehResult] =
+                        reader.query(
+                            "SELECT V.PLATE, VS.MAKE, VS.MODEL, V.YEAR, V.COLOUR FROM VEHICLES AS V INNER JOIN VEHICLESHAREDDATA AS VS ON V.BASE = VS.ID WHERE V.OWNER = :USR;", { {":USR", asInteger(cursor[0])} });
+
+                    if (!vehStatus)
+                    {
+                        failed = true;
+                        break;
+                    }
+
+                    responseWrapper temp;
+                    temp.add("ID", cursor[0]);
+                    temp.add("Username", cursor[1]);
+                    temp.add("Permissions", cursor[2]);
+                    for (size_t u = 0; u < vehResult.rowCount(); u++)
+                    {
+                        responseWrapper vehicleResponse;
+                        vehicleResponse.add("Vehicle plate", vehResult[u][0]);
+                        vehicleResponse.add("Vehicle Make", vehResult[u][1]);
+                        vehicleResponse.add("Vehicle Model", vehResult[u][2]);
+                        vehicleResponse.add("Vehicle Year", vehResult[u][3]);
+                        vehicleResponse.add("Vehicle Colour", vehResult[u][4]);
+                        temp.add("Vehicles", std::move(vehicleResponse), true);
+                    }
+                    response.add(temp);
+                    if (response.bufferedBytes() >= streamChunkSize)
+                    {
+                        stream.write(response.take());
+                    }
+                }
+
+                if (failed || !cursor)
+                {
+                    //If part of the response has already been sent the executor drops the connection instead
                     //Internal Server Error
-                    res->writeStatus(HTTPCodes::INTERNALERROR);
-                    res->end();
-                    return;
+                    return { HTTPCodes::INTERNALERROR };
                 }
 
-                responseWrapper temp;
-                temp.add("ID", result[i][0]);
-                temp.add("Username", result[i][1]);
-                temp.add("Permissions", result[i][2]);
-                for (size_t u = 0; u < vehResult.rowCount(); u++)
+                if (response.size() == 0)
                 {
-                    responseWrapper vehicleResponse;
-                    vehicleResponse.add("Vehicle plate", vehResult[u][0]);
-                    vehicleResponse.add("Vehicle Make", vehResult[u][1]);
-                    vehicleResponse.add("Vehicle Model", vehResult[u][2]);
-                    vehicleResponse.add("Vehicle Year", vehResult[u][3]);
-                    vehicleResponse.add("Vehicle Colour", vehResult[u][4]);
-                    temp.add("Vehicles", std::move(vehicleResponse), true);
+                    //No content
+                    return { HTTPCodes::NOTFOUND };
                 }
-                response.add("Users", std::move(temp));
-            }
-            res->tryEnd(response.toData(false));
-            return;
-        }
-        else
-        {
-            //No content
-            res->writeStatus(HTTPCodes::NOTFOUND);
-        }
-        res->end();
+                responseWrapper fields;
+                fields.add("next", next);
+                return { HTTPCodes::OK, response.finish(fields) };
+            });
     }
 
     void selectUser(uWS::HttpResponse<true>* res, uWS::HttpRequest* req, const body& b, const query& q)
@@ -203,55 +246,65 @@ namespace webRoute
 
         std::cout << "Session (" << serverData::auth->getSessionID(req).value() << ") selected user (\"" << q.getElement("ID") << "\").\n";
 
-        const auto [status, result] = serverData::database->query("SELECT ID, USERNAME, PERMISSIONS FROM " + serverData::tableNames[serverData::USER] + " WHERE ID = :ID",
-            { {":ID", q.getElement("ID")} });
-        if (!status)
-        {
-            //Internal Server Error
-            res->writeStatus(HTTPCodes::INTERNALERROR);
-            res->end();
+        const entityTag tag("/user/select", req->getQuery(), { serverData::USER, serverData::VEHICLES, serverData::VEHICLESHARED });
+        if (tag.answer(res, req))
             return;
-        }
-
-        if (result.rowCount() != 0)
-        {
-
-            const auto [vehStatus, vehResult] =
-                serverData::database->query(
-                    "SELECT V.ID, V.PLATE, VS.MAKE, VS.MODEL, V.YEAR, V.COLOUR FROM VEHICLES AS V INNER JOIN VEHICLESHAREDDATA AS VS ON V.BASE = VS.ID WHERE V.OWNER = :USR;", { {":USR", result[0][0]} });
 
-            if (!vehStatus)
+        //The lookup runs on a database thread, in parallel with other reads
+        serverData::executor->submit(res, [q, tag = tag.value()](sqlite3DB& reader) -> routeResult
             {
-                //Internal Server Error
-                res->writeStatus(HTTPCodes::INTERNALERROR);
-                res->end();
-                return;
-            }
+                const auto [status, result] = reader.query("SELECT ID, USERNAME, PERMISSIONS FROM " + serverData::tableNames[serverData::USER] + " WHERE ID = :ID",
+                    { {":ID", asInteger(q.getElement("ID"))} });
+                if (!status)
+                {
+                    //Internal Server Error
+                    return { HTTPCodes::INTERNALERROR };
+                }
 
-            responseWrapper response;
-            response.add("ID", result[0][0]);
-            response.add("Username", result[0][1]);
-            response.add("Permissions", result[0][2]);
-            for (size_t i = 0; i < vehResult.rowCount(); i++)
-            {
-                responseWrapper temp;
-                temp.add("ID", vehResult[i][0]);
-                temp.add("Plate", vehResult[i][1]);
-                temp.add("Make", vehResult[i][2]);
-                temp.add("Model", vehResult[i][3]);
-                temp.add("Year", vehResult[i][4]);
-                temp.add("Colour", vehResult[i][5]);
-                response.add("Vehicles", std::move(temp), true);
-            }
-            res->tryEnd(response.toData(false));
-            return;
-        }
-        else
-        {
-            //No content
-            res->writeStatus(HTTPCodes::NOTFOUND);
-        }
-        res->end();
+                if (result.rowCount() != 0)
+                {
+
+                    const auto [vehStatus, vehResult] =
+                        reader.query(
+                            "SELECT ID, PLATE, BASE, YEAR, COLOUR FROM " + serverData::tableNames[serverData::VEHICLES] + " WHERE OWNER = :USR;", { {":USR", asInteger(result[0][0])} });
+
+                    if (!vehStatus)
+                    {
+                        //Internal Server Error
+                        return { HTTPCodes::INTERNALERROR };
+                    }
+
+                    responseWrapper response;
+                    response.add("ID", result[0][0]);
+                    response.add("Username", result[0][1]);
+                    response.add("Permissions", result[0][2]);
+                    for (size_t i = 0; i < vehResult.rowCount(); i++)
+                    {
+                        //Makes and models are joined from the dictionary rather than by the query
+                        const auto model = serverData::models->find(reader, vehResult.getInteger(i, 2));
+                        if (!model.has_value())
+                        {
+                            //Internal Server Error
+                            return { HTTPCodes::INTERNALERROR };
+                        }
+
+                        responseWrapper temp;
+                        temp.add("ID", vehResult[i][0]);
+                        temp.add("Plate", vehResult[i][1]);
+                        temp.add("Make", model->make);
+                        temp.add("Model", model->model);
+                        temp.add("Year", vehResult[i][3]);
+                        temp.add("Colour", vehResult[i][4]);
+                        response.add("Vehicles", std::move(temp), true);
+                    }
+                    return { HTTPCodes::OK, response.toData(false), tag };
+                }
+                else
+                {
+                    //No content
+                    return { HTTPCodes::NOTFOUND };
+                }
+            });
     }
 
 
@@ -273,7 +326,7 @@ namespace webRoute
             return;
         }
 
-        const auto [pstatus, presult] = serverData::database->query("SELECT PERMISSIONS FROM " + serverData::tableNames[serverData::USER] + " WHERE ID = :ID", { {":ID", b.getElement("ID")} });
+        const auto [pstatus, presult] = serverData::database->query("SELECT PERMISSIONS FROM " + serverData::tableNames[serverData::USER] + " WHERE ID = :ID", { {":ID", asInteger(b.getElement("ID"))} });
         if (!pstatus)
         {
             //Internal Server Error
@@ -291,10 +344,8 @@ namespace webRoute
         }
 
         {
-            unsigned int deletedPermissions;
-
-            auto result = std::from_chars(presult[0][0].data(), presult[0][0].data() + presult[0][0].size(), deletedPermissions);
-            if (result.ec != std::errc())
+            const auto deletedPermissions = presult.getInteger(0, 0);
+            if (!deletedPermissions.has_value())
             {
                 //Internal Server Error
                 res->writeStatus(HTTPCodes::INTERNALERROR);
@@ -302,7 +353,7 @@ namespace webRoute
                 return;
             }
 
-            if (!serverData::auth->verify(req, static_cast<authLevel>(deletedPermissions)))
+            if (!serverData::auth->verify(req, static_cast<authLevel>(deletedPermissions.value())))
             {
                 //Forbidden - Insufficient permissions
                 res->writeStatus(HTTPCodes::FORBIDDEN);
@@ -312,7 +363,7 @@ namespace webRoute
         }
 
 
-        const auto [status, result] = serverData::database->query("DELETE FROM " + serverData::tableNames[serverData::USER] + " WHERE ID = :ID", { {":ID", b.getElement("ID")} });
+        const auto [status, result] = serverData::database->query("DELETE FROM " + serverData::tableNames[serverData::USER] + " WHERE ID = :ID", { {":ID", asInteger(b.getElement("ID"))} });
         if (!status)
         {
             //Internal Server Error
@@ -365,7 +416,7 @@ namespace webRoute
         }
 
         {
-            const auto [pstatus, presult] = serverData::database->query("SELECT PERMISSIONS FROM " + serverData::tableNames[serverData::USER] + " WHERE ID = :ID", { {":ID", b.getElement("ID")} });
+            const auto [pstatus, presult] = serverData::database->query("SELECT PERMISSIONS FROM " + serverData::tableNames[serverData::USER] + " WHERE ID = :ID", { {":ID", asInteger(b.getElement("ID"))} });
             if (!pstatus)
             {
                 //Internal Server Error
@@ -382,10 +433,8 @@ namespace webRoute
                 return;
             }
 
-            unsigned int modifiedPermissions;
-
-            auto result = std::from_chars(presult[0][0].data(), presult[0][0].data() + presult[0][0].size(), modifiedPermissions);
-            if (result.ec != std::errc())
+            const auto modifiedPermissions = presult.getInteger(0, 0);
+            if (!modifiedPermissions.has_value())
             {
                 //Internal Server Error
                 res->writeStatus(HTTPCodes::INTERNALERROR);
@@ -393,7 +442,7 @@ namespace webRoute
                 return;
             }
 
-            if (!serverData::auth->verify(req, static_cast<authLevel>(modifiedPermissions)))
+            if (!serverData::auth->verify(req, static_cast<authLevel>(modifiedPermissions.value())))
             {
                 //Forbidden - Insufficient permissions
                 res->writeStatus(HTTPCodes::FORBIDDEN);
@@ -413,7 +462,7 @@ namespace webRoute
             return;
         }
 
-        const auto [status, result] = serverData::database->query("UPDATE " + serverData::tableNames[serverData::USER] + " SET " + updateStatement + " WHERE ID = :ID", { {":ID", b.getElement("ID")} });
+        const auto [status, result] = serverData::database->query("UPDATE " + serverData::tableNames[serverData::USER] + " SET " + updateStatement + " WHERE ID = :ID", { {":ID", asInteger(b.getElement("ID"))} });
 
         if (!status)
         {
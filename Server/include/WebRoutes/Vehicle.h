@@ -1,6 +1,9 @@
 #pragma once
 #include "Network.h"
 #include "Response.h"
+#include "Executor.h"
+#include "Ownership.h"
+#include "VehicleModels.h"
 
 namespace webRoute
 {
@@ -23,9 +26,8 @@ namespace webRoute
             return;
         }
 
-        const auto [vStatus, vResult] = serverData::database->query("INSERT OR IGNORE INTO " + serverData::tableNames[serverData::VEHICLESHARED] + "(MAKE, MODEL) VALUES (:MAK, :MOD)",
-            { {":MAK", b.getElement("make")}, {":MOD", b.getElement("model")} });
-        if (!vStatus)
+        const auto base = serverData::models->resolve(*serverData::database, b.getElement("make"), b.getElement("model"));
+        if (!base.has_value())
         {
             //Internal server error
             res->writeStatus(HTTPCodes::INTERNALERROR);
@@ -33,13 +35,11 @@ namespace webRoute
             return;
         }
 
-        const auto [status, result] = serverData::database->query("INSERT INTO " + serverData::tableNames[serverData::VEHICLES] + " (PLATE, BASE, OWNER, YEAR, COLOUR) VALUES (:PLT, " + 
-            "(SELECT ID FROM " + serverData::tableNames[serverData::VEHICLESHARED] + " WHERE MAKE = :MAK AND MODEL = :MOD), :OWN, :YEA, :COL);", {
+        const auto [status, result] = serverData::database->query("INSERT INTO " + serverData::tableNames[serverData::VEHICLES] + " (PLATE, BASE, OWNER, YEAR, COLOUR) VALUES (:PLT, :BAS, :OWN, :YEA, :COL) RETURNING ID, OWNER;", {
                 {":PLT", b.getElement("plate")},
-                {":MAK", b.getElement("make")},
-                {":MOD", b.getElement("model")},
-                {":OWN", b.getElement("owner")},
-                {":YEA", b.getElement("year")},
+                {":BAS", base.value()},
+                {":OWN", asInteger(b.getElement("owner"))},
+                {":YEA", asInteger(b.getElement("year"))},
                 {":COL", b.getElement("colour")} });
 
         if (!status)
@@ -49,6 +49,10 @@ namespace webRoute
         }
         else
         {
+            const auto ID = result.getInteger(0, 0);
+            const auto owner = result.getInteger(0, 1);
+            if (ID.has_value() && owner.has_value())
+                serverData::owners->addVehicle(ID.value(), owner.value());
             std::cout << "Session (" << serverData::auth->getSessionID(req).value() << ") added new vehicle for (\"" << b.getElement("owner") << "\").\n";
         }
         res->end();
@@ -65,13 +69,20 @@ namespace webRoute
         }
 
         {
-            const auto [status, result] = serverData::database->query("SELECT OWNER FROM " + serverData::tableNames[serverData::VEHICLES] + " WHERE ID = :ID", { {":ID", b.getElement("ID")} });
-            if (!serverData::auth->isSessionUserFromID(req, result[0][0]) && !serverData::auth->verify(req, authLevel::manager))
+            const auto owner = serverData::owners->vehicleOwner(b.getElement("ID"));
+            if (!owner.has_value())
+            {
+                //Not found - No vehicle with that ID
+                res->writeStatus(HTTPCodes::NOTFOUND);
+                res->end();
+                return;
+            }
+            if (!serverData::auth->isSessionUser(req, owner) && !serverData::auth->verify(req, authLevel::manager))
             {
                 //Forbidden - Insufficient permissions
                 res->writeStatus(HTTPCodes::FORBIDDEN);
-                    res->end();
-                    return;
+                res->end();
+                return;
             }
         }
 
@@ -87,7 +98,7 @@ namespace webRoute
             return;
         }
 
-        const auto [status, result] = serverData::database->query("UPDATE " + serverData::tableNames[serverData::VEHICLES] + " SET " + updateStatement + " WHERE ID = :ID", { {":ID", b.getElement("ID")} });
+        const auto [status, result] = serverData::database->query("UPDATE " + serverData::tableNames[serverData::VEHICLES] + " SET " + updateStatement + " WHERE ID = :ID", { {":ID", asInteger(b.getElement("ID"))} });
 
         if (!status)
         {
@@ -110,8 +121,15 @@ namespace webRoute
         }
 
         {
-            const auto [status, result] = serverData::database->query("SELECT OWNER FROM " + serverData::tableNames[serverData::VEHICLES] + " WHERE ID = :ID", { {":ID", b.getElement("ID")} });
-            if (!serverData::auth->isSessionUserFromID(req, result[0][0]) && !serverData::auth->verify(req, authLevel::manager))
+            const auto owner = serverData::owners->vehicleOwner(b.getElement("ID"));
+            if (!owner.has_value())
+            {
+                //Not found - No vehicle with that ID
+                res->writeStatus(HTTPCodes::NOTFOUND);
+                res->end();
+                return;
+            }
+            if (!serverData::auth->isSessionUser(req, owner) && !serverData::auth->verify(req, authLevel::manager))
             {
                 //Forbidden - Insufficient permissions
                 res->writeStatus(HTTPCodes::FORBIDDEN);
@@ -120,7 +138,7 @@ namespace webRoute
             }
         }
 
-        const auto [status, result] = serverData::database->query("DELETE FROM " + serverData::tableNames[serverData::VEHICLES] + " WHERE ID = :ID", { {":ID", b.getElement("ID")} });
+        const auto [status, result] = serverData::database->query("DELETE FROM " + serverData::tableNames[serverData::VEHICLES] + " WHERE ID = :ID", { {":ID", asInteger(b.getElement("ID"))} });
         if (!status)
         {
             //Internal Server Error
@@ -128,6 +146,7 @@ namespace webRoute
             res->end();
             return;
         }
+        serverData::owners->removeVehicle(b.getElement("ID"));
 
         std::cout << "Session (" << serverData::auth->getSessionID(req).value() << ") deleted vehicle (\"" << b.getElement("ID") << "\").\n";
         res->end();
@@ -144,45 +163,65 @@ namespace webRoute
         }
 
         {
-            const auto [status, result] = serverData::database->query("SELECT OWNER FROM " + serverData::tableNames[serverData::VEHICLES] + " WHERE ID = :ID", { {":ID", q.getElement("ID")} });
-            if (!serverData::auth->isSessionUser(req, result[0][0]) && !serverData::auth->verify(req, authLevel::manager))
+            const auto owner = serverData::owners->vehicleOwner(q.getElement("ID"));
+            if (!owner.has_value())
             {
-                //Forbidden - Insufficient permissions
-                res->writeStatus(HTTPCodes::FORBIDDEN);
+                //Not found - No vehicle with that ID
+                res->writeStatus(HTTPCodes::NOTFOUND);
                 res->end();
                 return;
             }
-        }
-
-        const auto [vehStatus, vehResult] =
-             serverData::database->query(
-                    "SELECT V.ID, V.PLATE, VS.MAKE, VS.MODEL, V.YEAR, V.COLOUR FROM VEHICLES AS V INNER JOIN VEHICLESHAREDDATA AS VS ON V.BASE = VS.ID WHERE V.ID = :ID;", { {":ID", q.getElement("ID")} });
-
-            if (!vehStatus)
+            if (!serverData::auth->isSessionUser(req, owner) && !serverData::auth->verify(req, authLevel::manager))
             {
-                //Internal Server Error
-                res->writeStatus(HTTPCodes::INTERNALERROR);
+                //Forbidden - Insufficient permissions
+                res->writeStatus(HTTPCodes::FORBIDDEN);
                 res->end();
                 return;
             }
+        }
 
-            if (vehResult.rowCount() != 0)
-            {
-                responseWrapper response;
-                response.add("ID", vehResult[0][0]);
-                response.add("Plate", vehResult[0][1]);
-                response.add("Make", vehResult[0][2]);
-                response.add("Model", vehResult[0][3]);
-                response.add("Year", vehResult[0][4]);
-                response.add("Colour", vehResult[0][5]);
-                response.add("Owner", q.getElement("ID"));
-                res->tryEnd(response.toData(false));
-            }
-            else
+        //Only once the session may see the vehicle is an unchanged copy confirmed
+        const entityTag tag("/vehicle/select", req->getQuery(), { serverData::VEHICLES, serverData::VEHICLESHARED });
+        if (tag.answer(res, req))
+            return;
+
+        //The lookup runs on a database thread, in parallel with other reads
+        serverData::executor->submit(res, [q, tag = tag.value()](sqlite3DB& reader) -> routeResult
             {
-                res->writeStatus(HTTPCodes::NOTFOUND);
-                res->end();
-            }
+                const auto [vehStatus, vehResult] =
+                    reader.query(
+                        "SELECT ID, PLATE, BASE, YEAR, COLOUR FROM " + serverData::tableNames[serverData::VEHICLES] + " WHERE ID = :ID;", { {":ID", asInteger(q.getElement("ID"))} });
+
+                if (!vehStatus)
+                {
+                    //Internal Server Error
+                    return { HTTPCodes::INTERNALERROR };
+                }
+
+                if (vehResult.rowCount() != 0)
+                {
+                    const auto model = serverData::models->find(reader, vehResult.getInteger(0, 2));
+                    if (!model.has_value())
+                    {
+                        //Internal Server Error
+                        return { HTTPCodes::INTERNALERROR };
+                    }
+
+                    responseWrapper response;
+                    response.add("ID", vehResult[0][0]);
+                    response.add("Plate", vehResult[0][1]);
+                    response.add("Make", model->make);
+                    response.add("Model", model->model);
+                    response.add("Year", vehResult[0][3]);
+                    response.add("Colour", vehResult[0][4]);
+                    response.add("Owner", q.getElement("ID"));
+                    return { HTTPCodes::OK, response.toData(false), tag };
+                }
+                else
+                {
+                    return { HTTPCodes::NOTFOUND };
+                }
+            });
             return;
 
         std::cout << "Session (" << serverData::auth->getSessionID(req).value() << ") selected vehicle (\"" << b.getElement("ID") << "\").\n";
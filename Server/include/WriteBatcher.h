@@ -0,0 +1,173 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <functional>
+#include <string_view>
+#include <iostream>
+#include "libusockets.h"
+#include "uwebsockets/App.h"
+#include "Database.h"
+#include "Network.h"
+
+//Collects writes from many requests and commits them together in a single transaction (group commit)
+//Each write runs under its own savepoint, so a failing write is undone without affecting the rest of its batch
+//Must be created and used on the thread running the network loop
+class writeBatcher final
+{
+public:
+    //Runs inside the batch's transaction, returning the HTTP status the request should be answered with
+    using mutation = std::function<const char*()>;
+    //Runs once the write it belongs to has been committed
+    using completion = std::function<void()>;
+
+    struct settings
+    {
+        //How long the first write of a batch may wait for others to join it, never less than one millisecond
+        std::chrono::milliseconds window{ 2 };
+        //A batch is committed as soon as it holds this many writes, regardless of the window
+        size_t maxBatchSize = 64;
+    };
+
+private:
+    struct pendingWrite
+    {
+        uWS::HttpResponse<true>* res;
+        mutation apply;
+        completion committed;
+        //Set if the client disconnects before the batch is committed, after which the response may not be used
+        std::shared_ptr<bool> aborted;
+    };
+
+    sqlite3DB& database;
+    settings config;
+    std::vector<pendingWrite> pending;
+    us_timer_t* timer = nullptr;
+    bool timerArmed = false;
+
+    static void onTimer(us_timer_t* t)
+    {
+        (*static_cast<writeBatcher**>(us_timer_ext(t)))->flush();
+    }
+
+    static bool isSuccess(std::string_view status)
+    {
+        return !status.empty() && status.front() == '2';
+    }
+
+public:
+    writeBatcher(sqlite3DB& db, settings conf) : database(db), config(conf)
+    {
+        if (config.window.count() < 1)
+            config.window = std::chrono::milliseconds(1);
+        if (config.maxBatchSize < 1)
+            config.maxBatchSize = 1;
+
+        timer = us_create_timer(reinterpret_cast<us_loop_t*>(uWS::Loop::get()), 0, sizeof(writeBatcher*));
+        *static_cast<writeBatcher**>(us_timer_ext(timer)) = this;
+    }
+
+    //The timer refers back to this object, so it cannot be moved
+    writeBatcher(const writeBatcher&) = delete;
+    writeBatcher& operator=(const writeBatcher&) = delete;
+
+    //Writes still queued are committed, rather than dropped with their requests left unanswered
+    ~writeBatcher()
+    {
+        flush();
+        us_timer_close(timer);
+    }
+
+    //Queues a write, the response is finished (with the status returned by the write) once its batch is committed
+    //Takes over the response's abort handler
+    void submit(uWS::HttpResponse<true>* res, mutation apply, completion committed = {})
+    {
+        auto aborted = std::make_shared<bool>(false);
+        res->onAborted([aborted]()
+            {
+                *aborted = true;
+            });
+
+        pending.push_back({ res, std::move(apply), std::move(committed), std::move(aborted) });
+
+        if (pending.size() >= config.maxBatchSize)
+        {
+            flush();
+        }
+        else if (!timerArmed)
+        {
+            us_timer_set(timer, onTimer, static_cast<int>(config.window.count()), 0);
+            timerArmed = true;
+        }
+    }
+
+    //Commits every queued write and answers their requests
+    void flush()
+    {
+        if (timerArmed)
+        {
+            //A zero timeout disarms the timer
+            us_timer_set(timer, onTimer, 0, 0);
+            timerArmed = false;
+        }
+        if (pending.empty())
+            return;
+
+        std::vector<pendingWrite> batch;
+        batch.swap(pending);
+        std::vector<const char*> statuses(batch.size(), HTTPCodes::INTERNALERROR);
+
+        {
+            auto transaction = database.transaction();
+            if (transaction)
+            {
+                for (size_t i = 0; i < batch.size(); i++)
+                {
+                    auto savepoint = database.transaction();
+                    if (!savepoint)
+                        continue;
+
+                    //A write which throws fails alone, the rest of the batch is still committed and every request answered
+                    try
+                    {
+                        statuses[i] = batch[i].apply();
+                    }
+                    catch (const std::exception& e)
+                    {
+                        std::cout << "Batched write failed: " << e.what() << "\n";
+                        statuses[i] = HTTPCodes::INTERNALERROR;
+                    }
+                    catch (...)
+                    {
+                        std::cout << "Batched write failed.\n";
+                        statuses[i] = HTTPCodes::INTERNALERROR;
+                    }
+                    //Writes which did not succeed are rolled back when the savepoint leaves scope
+                    if (isSuccess(statuses[i]) && !savepoint.commit())
+                        statuses[i] = HTTPCodes::INTERNALERROR;
+                }
+
+                if (!transaction.commit())
+                {
+                    std::cout << "Failed to commit a batch of " << batch.size() << " writes.\n";
+                    std::fill(statuses.begin(), statuses.end(), HTTPCodes::INTERNALERROR);
+                }
+            }
+        }
+
+        for (size_t i = 0; i < batch.size(); i++)
+        {
+            if (isSuccess(statuses[i]) && batch[i].committed)
+                batch[i].committed();
+
+            if (*batch[i].aborted)
+                continue;
+            //Responses are written from outside of their request handlers, so must be corked
+            batch[i].res->cork([&]()
+                {
+                    batch[i].res->writeStatus(statuses[i]);
+                    batch[i].res->end();
+                });
+        }
+    }
+};
@@ -0,0 +1,518 @@
+#include "Benchmark.h"
+#include "Database.h"
+#include "ServerData.h"
+#include "PartsCatalogue.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <thread>
+#include <atomic>
+
+namespace
+{
+    //Splits console arguments on spaces
+    std::vector<std::string> splitArguments(std::string_view args)
+    {
+        std::vector<std::string> ret;
+        std::istringstream stream{ std::string(args) };
+        std::string arg;
+        while (stream >> arg)
+            ret.push_back(arg);
+        return ret;
+    }
+
+    //Runs every line of the schema file, quietly
+    bool createSchema(sqlite3DB& DB, const std::string& schemaFile)
+    {
+        std::ifstream in(schemaFile);
+        if (!in)
+            return false;
+
+        std::string line;
+        while (std::getline(in, line))
+        {
+            if (line.empty())
+                continue;
+            if (!DB.query(line, {}).first)
+                return false;
+        }
+        return true;
+    }
+
+    //Fills the tables a service request depends on
+    bool seedServiceData(sqlite3DB& DB, size_t parts)
+    {
+        auto transaction = DB.transaction();
+        if (!transaction)
+            return false;
+
+        bool ok = DB.query("INSERT INTO " + serverData::tableNames[serverData::USER] + " (ID, USERNAME, PASSWORD, PERMISSIONS) VALUES (1, 'BENCH', '', 3)", {}).first;
+        ok = ok && DB.query("INSERT INTO " + serverData::tableNames[serverData::SUPPLIERS] + " (ID, NAME) VALUES (1, 'BENCH')", {}).first;
+        ok = ok && DB.query("INSERT INTO " + serverData::tableNames[serverData::VEHICLESHARED] + " (ID, MAKE, MODEL) VALUES (1, 'MAKE', 'MODEL')", {}).first;
+        ok = ok && DB.query("INSERT INTO " + serverData::tableNames[serverData::VEHICLES] + " (ID, PLATE, BASE, OWNER, YEAR, COLOUR) VALUES (1, 'BENCH', 1, 1, 2000, 'RED')", {}).first;
+        for (size_t i = 1; ok && i <= parts; i++)
+        {
+            ok = DB.query("INSERT INTO " + serverData::tableNames[serverData::PARTS] + " (ID, NAME, QUANTITY, SUPPLIER, PRICE) VALUES (:ID, :NAM, 100, 1, 10)",
+                { {":ID", i}, {":NAM", "Part " + std::to_string(i)} }).first;
+        }
+        return ok && transaction.commit();
+    }
+
+    //Issues the same statements as the service routes, returning the number of requests completed
+    //Each iteration is four requests: create a service, add a part to it, update it and read it back
+    size_t runServiceRequests(sqlite3DB& DB, size_t iterations, size_t parts)
+    {
+        const std::string create = "INSERT INTO " + serverData::tableNames[serverData::SERVICES] + "(VEHICLE, REQUESTED, REQUEST) VALUES (1, (SELECT date('now')), :REQ)";
+        const std::string findPart = "SELECT ID FROM " + serverData::tableNames[serverData::PARTSINSERVICE] + " WHERE SERVICE = :SID AND PART = :PRT";
+        const std::string addPart = "INSERT INTO " + serverData::tableNames[serverData::PARTSINSERVICE] + "(PART, QUANTITY, SERVICE) VALUES (:PRT, 1, :SRV)";
+        const std::string addTotal = "UPDATE " + serverData::tableNames[serverData::SERVICES] + " SET TOTAL = TOTAL + (SELECT PRICE FROM " + serverData::tableNames[serverData::PARTS] + " WHERE ID = :PRT), PARTCOUNT = PARTCOUNT + 1 WHERE ID = :SRV";
+        const std::string update = "UPDATE " + serverData::tableNames[serverData::SERVICES] + " SET REQUEST = :REQ WHERE ID = :ID";
+        const std::string select = "SELECT S.ID, S.REQUEST, P.NAME, P.PRICE, PIS.QUANTITY FROM " + serverData::tableNames[serverData::SERVICES] + " AS S" +
+            " INNER JOIN " + serverData::tableNames[serverData::PARTSINSERVICE] + " AS PIS ON PIS.SERVICE = S.ID" +
+            " INNER JOIN " + serverData::tableNames[serverData::PARTS] + " AS P ON P.ID = PIS.PART WHERE S.ID = :ID";
+
+        size_t completed = 0;
+        for (size_t i = 1; i <= iterations; i++)
+        {
+            if (!DB.query(create, { {":REQ", "Benchmark request"} }).first)
+                return completed;
+            completed++;
+            {
+                auto transaction = DB.transaction();
+                const SQLValue part = static_cast<int64_t>(i % parts + 1);
+                if (!transaction || !DB.query(findPart, { {":SID", i}, {":PRT", part} }).first || !DB.query(addPart, { {":PRT", part}, {":SRV", i} }).first ||
+                    !DB.query(addTotal, { {":PRT", part}, {":SRV", i} }).first || !transaction.commit())
+                    return completed;
+                completed++;
+            }
+            if (!DB.query(update, { {":REQ", "Updated benchmark request"}, {":ID", i} }).first)
+                return completed;
+            completed++;
+
+            const auto [status, result] = DB.query(select, { {":ID", i} });
+            if (!status || result.rowCount() != 1)
+                return completed;
+            completed++;
+        }
+        return completed;
+    }
+
+    //Adds open services, each holding partsPerService parts, to the data from seedServiceData
+    bool seedOpenServices(sqlite3DB& DB, size_t first, size_t count, size_t parts, size_t partsPerService)
+    {
+        auto transaction = DB.transaction();
+        if (!transaction)
+            return false;
+
+        //Every seeded part costs 10, and is added twice
+        const std::string open = "INSERT INTO " + serverData::tableNames[serverData::SERVICES] + " (ID, VEHICLE, REQUESTED, REQUEST, STATUS, LABOUR, NOTES, AUTHORISER, QUOTE, TOTAL, PARTCOUNT) " +
+            "VALUES (:ID, 1, 0, 'Benchmark request', 'open', 1, '', 1, 0, :TOT, :CNT)";
+        const std::string part = "INSERT INTO " + serverData::tableNames[serverData::PARTSINSERVICE] + " (PART, QUANTITY, SERVICE) VALUES (:PRT, 2, :ID)";
+
+        bool ok = true;
+        for (size_t i = first; ok && i < first + count; i++)
+        {
+            ok = DB.query(open, { {":ID", i}, {":TOT", partsPerService * 20}, {":CNT", partsPerService * 2} }).first;
+            for (size_t p = 0; ok && p < partsPerService; p++)
+            {
+                ok = DB.query(part, { {":PRT", (i * partsPerService + p) % parts + 1}, {":ID", i} }).first;
+            }
+        }
+        return ok && transaction.commit();
+    }
+
+    //The open services part of searchServices, reading the parts either with a query per service or in one query for them all
+    //Returns the number of parts read, or nothing if a query failed
+    std::optional<size_t> searchOpenServices(sqlite3DB& DB, bool perService)
+    {
+        const std::string openServices = " FROM " + serverData::tableNames[serverData::SERVICES] + " AS S" +
+            " INNER JOIN " + serverData::tableNames[serverData::VEHICLES] + " AS V ON S.VEHICLE = V.ID WHERE S.STATUS = 'open'";
+        const std::string partColumns = "SELECT PS.SERVICE, PS.ID, P.NAME, PS.PART, PS.QUANTITY, P.PRICE FROM " + serverData::tableNames[serverData::PARTSINSERVICE] + " AS PS" +
+            " INNER JOIN " + serverData::tableNames[serverData::PARTS] + " AS P ON PS.PART = P.ID";
+
+        const auto [status, result] = DB.query("SELECT S.ID, S.VEHICLE, V.OWNER, S.REQUEST, S.REQUESTED, S.LABOUR, S.NOTES, S.AUTHORISER, S.QUOTE" + openServices, {});
+        if (!status)
+            return {};
+
+        size_t read = 0;
+        if (perService)
+        {
+            for (size_t i = 0; i < result.rowCount(); i++)
+            {
+                const auto [partStatus, partResult] = DB.query(partColumns + " WHERE PS.SERVICE = :ID", { {":ID", result.getInteger(i, 0).value_or(-1)} });
+                if (!partStatus)
+                    return {};
+                read += partResult.rowCount();
+            }
+        }
+        else
+        {
+            const auto [partStatus, partResult] = DB.query(partColumns + " WHERE PS.SERVICE IN (SELECT S.ID" + openServices + ")", {});
+            if (!partStatus)
+                return {};
+            std::unordered_map<int64_t, std::vector<size_t>> grouped;
+            for (size_t i = 0; i < partResult.rowCount(); i++)
+            {
+                grouped[partResult.getInteger(i, 0).value_or(-1)].push_back(i);
+            }
+            for (size_t i = 0; i < result.rowCount(); i++)
+            {
+                if (const auto it = grouped.find(result.getInteger(i, 0).value_or(-1)); it != grouped.end())
+                    read += it->second.size();
+            }
+        }
+        return read;
+    }
+
+    //Fills the parts catalogue with distinct, realistically worded names, such as "Front brake pad BP-000042"
+    bool seedPartCatalogue(sqlite3DB& DB, size_t parts)
+    {
+        auto transaction = DB.transaction();
+        if (!transaction)
+            return false;
+
+        const char* positions[] = { "Front", "Rear", "Left", "Right", "Upper", "Lower" };
+        const char* components[] = { "brake pad", "brake disc", "oil filter", "air filter", "spark plug", "wiper blade", "headlamp bulb", "timing belt", "water pump", "clutch plate",
+            "shock absorber", "wheel bearing", "fuel pump", "radiator hose", "alternator belt", "exhaust clamp" };
+        constexpr size_t componentCount = sizeof(components) / sizeof(components[0]);
+
+        bool ok = DB.query("INSERT INTO " + serverData::tableNames[serverData::SUPPLIERS] + " (ID, NAME) VALUES (1, 'BENCH')", {}).first;
+        const std::string part = "INSERT INTO " + serverData::tableNames[serverData::PARTS] + " (ID, NAME, QUANTITY, SUPPLIER, PRICE) VALUES (:ID, :NAM, 100, 1, 10)";
+        for (size_t i = 1; ok && i <= parts; i++)
+        {
+            const std::string code = std::to_string(1000000 + i).substr(1);
+            const std::string name = std::string(positions[i % 6]) + " " + components[(i / 6) % componentCount] + " " +
+                static_cast<char>('A' + i % 26) + static_cast<char>('A' + (i / 26) % 26) + "-" + code;
+            ok = DB.query(part, { {":ID", i}, {":NAM", name} }).first;
+        }
+        return ok && transaction.commit();
+    }
+
+    //The statement searchParts ran for a name before parts were searched in memory
+    //Returns the number of parts found, or nothing if the query failed
+    std::optional<size_t> searchPartNames(sqlite3DB& DB, std::string_view name)
+    {
+        auto cursor = DB.cursor("SELECT P.ID, P.NAME, P.PRICE, P.QUANTITY, S.NAME, G.ID FROM " + serverData::tableNames[serverData::PARTS] + " AS P" +
+            " LEFT JOIN " + serverData::tableNames[serverData::PARTGROUPS] + " AS G ON P.SIMILAR = G.ID " +
+            "INNER JOIN " + serverData::tableNames[serverData::SUPPLIERS] + " AS S ON P.SUPPLIER = S.ID WHERE P.NAME LIKE :NAM", { {":NAM", generateLIKEArgument(name)} });
+
+        size_t found = 0;
+        while (cursor.next())
+            found++;
+        if (!cursor)
+            return {};
+        return found;
+    }
+
+    void removeDatabaseFile(const std::string& file)
+    {
+        std::remove(file.c_str());
+        std::remove((file + "-wal").c_str());
+        std::remove((file + "-shm").c_str());
+        std::remove((file + "-journal").c_str());
+    }
+}
+
+void benchmarkStorage(sqlite3DB&, const std::string_view& args)
+{
+    const auto arguments = splitArguments(args);
+    if (arguments.empty())
+    {
+        std::cout << "Usage: \\bm <schema file> [requests]\n";
+        return;
+    }
+    size_t requests = 20000;
+    if (arguments.size() > 1)
+        requests = std::stoull(arguments[1]);
+    const size_t iterations = requests / 4;
+    constexpr size_t parts = 1000;
+    const std::string file = "benchmark.db";
+
+    struct storageMode
+    {
+        const char* name;
+        bool fileBacked;
+        //File-backed modes either use the server's configuration (WAL) or SQLite's default durable journaling
+        bool configured;
+    };
+    const storageMode modes[] =
+    {
+        { "In-memory", false, false },
+        { "File, WAL, synchronous=NORMAL", true, true },
+        { "File, rollback journal, synchronous=FULL", true, false }
+    };
+
+    for (const auto& mode : modes)
+    {
+        removeDatabaseFile(file);
+        sqlite3DB bench = mode.fileBacked ? sqlite3DB(std::string_view(file)) : sqlite3DB(nullptr);
+
+        //There is no background checkpointer here, so SQLite's automatic checkpoints are left on
+        databaseSettings settings;
+        settings.file = file;
+        settings.checkpointInterval = std::chrono::seconds(0);
+        const bool opened = bench.isOpen() &&
+            (mode.configured ? bench.configure(settings).isOK() : !mode.fileBacked || bench.query("PRAGMA synchronous=FULL", {}).first.isOK());
+        if (!opened)
+        {
+            std::cout << mode.name << ": failed to open database.\n";
+            continue;
+        }
+
+        if (!createSchema(bench, arguments[0]) || !seedServiceData(bench, parts))
+        {
+            std::cout << mode.name << ": failed to create schema.\n";
+            continue;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        const size_t completed = runServiceRequests(bench, iterations, parts);
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        std::cout << mode.name << ": " << completed << " requests in " << elapsed.count() << "s (" << static_cast<size_t>(completed / elapsed.count()) << " requests/s)";
+        if (completed != iterations * 4)
+            std::cout << ", stopped early on a failed query";
+        std::cout << ".\n";
+    }
+    removeDatabaseFile(file);
+}
+
+void benchmarkServiceSearch(sqlite3DB&, const std::string_view& args)
+{
+    const auto arguments = splitArguments(args);
+    if (arguments.empty())
+    {
+        std::cout << "Usage: \\bs <schema file> [services]\n";
+        return;
+    }
+    size_t maxServices = 8000;
+    if (arguments.size() > 1)
+        maxServices = std::stoull(arguments[1]);
+    constexpr size_t parts = 1000;
+    constexpr size_t partsPerService = 3;
+    constexpr size_t repeats = 5;
+
+    sqlite3DB bench(nullptr);
+    if (!bench.isOpen() || !createSchema(bench, arguments[0]) || !seedServiceData(bench, parts))
+    {
+        std::cout << "Failed to create schema.\n";
+        return;
+    }
+
+    size_t services = 0;
+    for (size_t target = 125; target <= maxServices; target *= 2)
+    {
+        if (!seedOpenServices(bench, services + 1, target - services, parts, partsPerService))
+        {
+            std::cout << "Failed to add services.\n";
+            return;
+        }
+        services = target;
+
+        std::cout << services << " open services:";
+        for (const bool perService : { true, false })
+        {
+            //The best of several runs, so the result is not skewed by the first run warming the caches
+            double best = std::numeric_limits<double>::max();
+            std::optional<size_t> read;
+            for (size_t i = 0; i < repeats; i++)
+            {
+                const auto start = std::chrono::steady_clock::now();
+                read = searchOpenServices(bench, perService);
+                const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+                best = std::min(best, elapsed.count());
+            }
+            if (!read.has_value() || read.value() != services * partsPerService)
+            {
+                std::cout << " query failed.\n";
+                return;
+            }
+            std::cout << (perService ? " query per service " : ", single parts query ") << best << "ms";
+        }
+        std::cout << ".\n";
+    }
+}
+
+void benchmarkPartSearch(sqlite3DB&, const std::string_view& args)
+{
+    const auto arguments = splitArguments(args);
+    if (arguments.empty())
+    {
+        std::cout << "Usage: \\ps <schema file> [parts]\n";
+        return;
+    }
+    size_t parts = 1000000;
+    if (arguments.size() > 1)
+        parts = std::stoull(arguments[1]);
+    constexpr size_t repeats = 3;
+    //From a single part to a tenth of the catalogue
+    const char* terms[] = { "DB-000029", "-00012", "wheel bearing", "Front", "pad" };
+
+    sqlite3DB bench(nullptr);
+    if (!bench.isOpen() || !createSchema(bench, arguments[0]))
+    {
+        std::cout << "Failed to create schema.\n";
+        return;
+    }
+
+    {
+        const auto start = std::chrono::steady_clock::now();
+        if (!seedPartCatalogue(bench, parts))
+        {
+            std::cout << "Failed to add parts.\n";
+            return;
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << parts << " parts added in " << elapsed.count() << "s.\n";
+    }
+
+    partsCatalogue catalogue;
+    {
+        const auto start = std::chrono::steady_clock::now();
+        if (!catalogue.load(bench))
+        {
+            std::cout << "Failed to load the parts catalogue.\n";
+            return;
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << "Parts catalogue loaded in " << elapsed.count() << "s.\n";
+    }
+
+    for (const char* term : terms)
+    {
+        std::cout << "\"" << term << "\":";
+        //The best of several runs, so the result is not skewed by the first run warming the caches
+        double best = std::numeric_limits<double>::max();
+        std::optional<size_t> found;
+        for (size_t i = 0; i < repeats; i++)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            found = searchPartNames(bench, term);
+            const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            best = std::min(best, elapsed.count());
+        }
+        if (!found.has_value())
+        {
+            std::cout << " query failed.\n";
+            return;
+        }
+        std::cout << " LIKE " << best << "ms";
+
+        //The catalogue only finds the page a request asks for, so it is timed for the first page of the default size
+        best = std::numeric_limits<double>::max();
+        size_t pageRows = 0;
+        for (size_t i = 0; i < repeats; i++)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            pageRows = catalogue.search(std::string_view(term), std::nullopt, pageRequest()).rows.size();
+            const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            best = std::min(best, elapsed.count());
+        }
+        std::cout << ", catalogue " << best << "ms (" << found.value() << " parts, " << pageRows << " on the first page).\n";
+    }
+}
+
+void benchmarkConcurrentReads(sqlite3DB&, const std::string_view& args)
+{
+    const auto arguments = splitArguments(args);
+    if (arguments.empty())
+    {
+        std::cout << "Usage: \\cr <schema file> [readers] [writes]\n";
+        return;
+    }
+    size_t readers = 4;
+    if (arguments.size() > 1)
+        readers = std::stoull(arguments[1]);
+    size_t writes = 1000;
+    if (arguments.size() > 2)
+        writes = std::stoull(arguments[2]);
+    constexpr size_t parts = 1000;
+    constexpr size_t services = 500;
+    constexpr size_t partsPerService = 3;
+    const std::string file = "benchmark.db";
+    //Named apart from the server's own database, which the console may already have open
+    constexpr std::string_view memory = "file:/WFABenchmark?vfs=memdb";
+
+    struct readMode
+    {
+        const char* name;
+        bool fileBacked;
+        //Whether each reader opens a connection of its own, rather than reading through the writer
+        bool ownConnections;
+    };
+    const readMode modes[] =
+    {
+        { "In-memory, reading through the writer", false, false },
+        { "In-memory, a connection per reader", false, true },
+        { "File, WAL, a connection per reader", true, true }
+    };
+
+    const std::string update = "UPDATE " + serverData::tableNames[serverData::SERVICES] + " SET REQUEST = :REQ WHERE ID = :ID";
+    for (const auto& mode : modes)
+    {
+        removeDatabaseFile(file);
+        const std::string_view source = mode.fileBacked ? std::string_view(file) : memory;
+        sqlite3DB bench(source);
+
+        databaseSettings settings;
+        settings.file = mode.fileBacked ? file : std::string();
+        settings.checkpointInterval = std::chrono::seconds(0);
+        if (!bench.isOpen() || !bench.configure(settings))
+        {
+            std::cout << mode.name << ": failed to open database.\n";
+            continue;
+        }
+        if (!createSchema(bench, arguments[0]) || !seedServiceData(bench, parts) || !seedOpenServices(bench, 1, services, parts, partsPerService))
+        {
+            std::cout << mode.name << ": failed to create schema.\n";
+            continue;
+        }
+
+        //Each reader repeats the open services search until the writes are done
+        std::atomic<bool> done = false;
+        std::atomic<size_t> reads = 0;
+        std::atomic<size_t> failedReads = 0;
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < readers; i++)
+        {
+            threads.emplace_back([&]()
+                {
+                    std::optional<sqlite3DB> own;
+                    if (mode.ownConnections)
+                        own.emplace(source, true);
+                    sqlite3DB& reader = own.has_value() ? *own : bench;
+                    while (!done)
+                    {
+                        if (reader.isOpen() && searchOpenServices(reader, false).has_value())
+                            reads++;
+                        else
+                            failedReads++;
+                    }
+                });
+        }
+
+        //Writes run one at a time, as the network loop runs them, the slowest is how long the loop could be held up
+        double slowest = 0;
+        size_t failedWrites = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < writes; i++)
+        {
+            const auto writeStart = std::chrono::steady_clock::now();
+            if (!bench.query(update, { {":REQ", "Benchmark request " + std::to_string(i)}, {":ID", i % services + 1} }).first)
+                failedWrites++;
+            const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - writeStart;
+            slowest = std::max(slowest, elapsed.count());
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        done = true;
+        for (auto& i : threads)
+        {
+            i.join();
+        }
+
+        std::cout << mode.name << ": " << writes << " writes in " << elapsed.count() << "s (slowest " << slowest << "ms, " << failedWrites << " failed), " <<
+            reads << " reads alongside (" << static_cast<size_t>(reads / elapsed.count()) << " reads/s, " << failedReads << " failed).\n";
+    }
+    removeDatabaseFile(file);
+}
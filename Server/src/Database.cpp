@@ -9,6 +9,32 @@ std::string generateLIKEArgument(std::string_view val)
     return ret;
 }
 
+bool isTrigramSearchable(std::string_view val)
+{
+    size_t characters = 0;
+    for (const char i : val)
+    {
+        //UTF-8 continuation bytes do not start a character
+        if ((static_cast<unsigned char>(i) & 0xC0) != 0x80)
+            characters++;
+    }
+    return characters >= 3;
+}
+
+std::string generateMATCHArgument(std::string_view val)
+{
+    std::string ret = "\"";
+    for (const char i : val)
+    {
+        //Quotes within a phrase are escaped by doubling them
+        if (i == '"')
+            ret += '"';
+        ret += i;
+    }
+    ret += "\"";
+    return ret;
+}
+
 std::string generateUpdateStatement(const body& b, const std::unordered_map<std::string, std::string>& relations)
 {
     std::string ret;
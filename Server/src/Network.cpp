@@ -1,4 +1,9 @@
 #include "Network.h"
+#include "WriteBatcher.h"
+#include "Executor.h"
+#include "Ownership.h"
+#include "VehicleModels.h"
+#include "PartsCatalogue.h"
 #include "WebRoutes/Auth.h"
 #include "WebRoutes/User.h"
 #include "WebRoutes/Parts.h"
@@ -7,11 +12,31 @@
 #include "curl/curl.h"
 
 //The main linking of the system, matches each request to a specific function
-void net()
+void net(const databaseSettings& settings)
 {
     uWS::SSLApp app;
     app.listen(9001, [&](auto*){});
 
+    //Writes from concurrent requests are gathered for up to 2ms (or 64 writes) and committed together
+    writeBatcher writes(*serverData::database, { std::chrono::milliseconds(2), 64 });
+    serverData::writes = &writes;
+    //Reads are moved off the network loop, onto threads with connections of their own
+    dbExecutor executor(*serverData::database, settings);
+    serverData::executor = &executor;
+    //Loaded only now, as the console may have changed or replaced the database
+    ownershipIndex owners;
+    if (!owners.load(*serverData::database))
+        std::cout << "Failed to load vehicle and service owners.\n";
+    serverData::owners = &owners;
+    vehicleModels models;
+    if (!models.load(*serverData::database))
+        std::cout << "Failed to load vehicle makes and models.\n";
+    serverData::models = &models;
+    partsCatalogue catalogue;
+    if (!catalogue.load(*serverData::database))
+        std::cout << "Failed to load the parts catalogue.\n";
+    serverData::catalogue = &catalogue;
+
     app.post("/request", HttpCallWrapper(webRoute::authenticate));
     app.post("/register", HttpCallWrapper(webRoute::registerUser));
     app.get("/release", webRoute::deauthenticate);
@@ -70,59 +95,71 @@ void net()
                 for (size_t x = 0; x < tables.rowCount(); x++)
                 {
                     std::cout << tables[x][0] << ":";
-                    const auto [code, result] = serverData::database->query("SELECT * FROM " + std::string(tables[x][0]), {});
-                    if (!code)
-                    {
-                        std::cout << "Error displaying table rows.\n";
-                    }
-                    else
-                    {
-                        if (result.columnCount() == 0 || result.rowCount() == 0)
-                        {
-                            std::cout << " empty.\n";
-                            continue;
-                        }
-                        std::cout << "\n";
+                    const std::string SQL = "SELECT * FROM " + std::string(tables[x][0]);
 
-                        std::vector<size_t> sizes(result.columnCount(), 0);
-                        for (size_t r = 0; r < result.rowCount(); r++)
+                    //Rows are never held in memory, so the table is read once to size the columns and again to print them
+                    std::vector<size_t> sizes;
+                    {
+                        auto cursor = serverData::database->cursor(SQL, {});
+                        while (cursor.next())
                         {
-                            for (size_t c = 0; c < result.columnCount(); c++)
+                            if (sizes.empty())
                             {
-                                if (result[r][c].size() > sizes[c])
-                                    sizes[c] = result[r][c].size();
+                                sizes.resize(cursor.columnCount(), 0);
+                                for (size_t c = 0; c < cursor.columnCount(); c++)
+                                    sizes[c] = cursor.getColName(c).size();
                             }
-                        }
-
-                        std::cout << '|';
-                        for (size_t c = 0; c < result.columnCount(); c++)
-                        {
-                            if (result.getColName(c).size() > sizes[c])
-                                sizes[c] = result.getColName(c).size();
-
-                            std::cout << result.getColName(c);
-                            for (size_t i = result.getColName(c).size(); i < sizes[c]; i++)
+                            for (size_t c = 0; c < cursor.columnCount(); c++)
                             {
-                                std::cout << ' ';
+                                if (cursor[c].size() > sizes[c])
+                                    sizes[c] = cursor[c].size();
                             }
-                            std::cout << '|';
                         }
-                        std::cout << "\n";
+                        if (!cursor)
+                        {
+                            std::cout << "Error displaying table rows.\n";
+                            continue;
+                        }
+                    }
 
-                        for (size_t row = 0; row < result.rowCount(); row++)
+                    if (sizes.empty())
+                    {
+                        std::cout << " empty.\n";
+                        continue;
+                    }
+                    std::cout << "\n";
+
+                    auto cursor = serverData::database->cursor(SQL, {});
+                    bool header = true;
+                    while (cursor.next())
+                    {
+                        if (header)
                         {
                             std::cout << '|';
-                            for (size_t col = 0; col < result.columnCount(); col++)
+                            for (size_t c = 0; c < cursor.columnCount(); c++)
                             {
-                                std::cout << result[row][col];
-                                for (size_t i = result[row][col].size(); i < sizes[col]; i++)
+                                std::cout << cursor.getColName(c);
+                                for (size_t i = cursor.getColName(c).size(); i < sizes[c]; i++)
                                 {
                                     std::cout << ' ';
                                 }
                                 std::cout << '|';
                             }
                             std::cout << "\n";
+                            header = false;
                         }
+
+                        std::cout << '|';
+                        for (size_t col = 0; col < cursor.columnCount(); col++)
+                        {
+                            std::cout << cursor[col];
+                            for (size_t i = cursor[col].size(); i < sizes[col]; i++)
+                            {
+                                std::cout << ' ';
+                            }
+                            std::cout << '|';
+                        }
+                        std::cout << "\n";
                     }
                 }
             }
@@ -152,5 +189,12 @@ void net()
 
     std::cout << "Network ready.\n";
     app.run();
+    //Queued writes may update the in-memory indexes once committed, so must be committed while they still exist
+    writes.flush();
+    serverData::executor = nullptr;
+    serverData::writes = nullptr;
+    serverData::owners = nullptr;
+    serverData::models = nullptr;
+    serverData::catalogue = nullptr;
     std::cin.ignore();
 }
@@ -3,6 +3,11 @@
 
 sqlite3DB* serverData::database = nullptr;
 authenticator* serverData::auth = nullptr;
+writeBatcher* serverData::writes = nullptr;
+dbExecutor* serverData::executor = nullptr;
+ownershipIndex* serverData::owners = nullptr;
+vehicleModels* serverData::models = nullptr;
+partsCatalogue* serverData::catalogue = nullptr;
 
 //Table names as found in sqlcrt.txt
 const std::vector<std::string> serverData::tableNames
@@ -14,9 +19,7 @@ const std::vector<std::string> serverData::tableNames
 	"PARTSINSERVICE",
 	"VEHICLESHAREDDATA",
 	"VEHICLES",
-	"SERVICESHAREDDATA",
-	"UNAUTHORISEDSERVICES",
-	"ACTIVESERVICEDATA",
-	"OPENSERVICES",
-	"CLOSEDSERVICES"
+	"SERVICES",
+	"SUPPLIERS_SEARCH",
+	"USERS_SEARCH"
 };
\ No newline at end of file
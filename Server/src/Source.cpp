@@ -1,5 +1,7 @@
 #include "Network.h"
 #include "Database.h"
+#include "PeriodicTask.h"
+#include "Benchmark.h"
 
 void printResult(const SQLResult& result)
 {
@@ -109,31 +111,93 @@ void autoexec(sqlite3DB& DB, const std::string_view& args)
     std::cout << "Done.\n";
 }
 
-void load(sqlite3DB& DB, const std::string_view& args)
+//Moves the server onto another database file, set up as the startup connection was
+//The settings are updated so that everything opened once the console exits (the readers, checkpoints) uses the new file
+void load(sqlite3DB& DB, databaseSettings& settings, const std::string_view& args)
 {
-    DB = sqlite3DB(args);
-    if (!DB.isOpen())
+    databaseSettings loaded = settings;
+    loaded.file = args;
+    sqlite3DB replacement(loaded.source());
+    if (!replacement.isOpen() || !replacement.configure(loaded))
+    {
         std::cout << "Failed to open " << args << ".\n";
-    else
-        std::cout << "Opened DB file.\n";
+        return;
+    }
+    replacement.auditPlans(loaded.planAuditRows);
+    replacement.trackTables(serverData::tableNames);
+    replacement.enableResultCache(loaded.resultCacheBytes);
+
+    DB = std::move(replacement);
+    settings = std::move(loaded);
+    std::cout << "Opened DB file.\n";
+}
+
+//Prints the prepared statement cache counters
+void statementStatistics(sqlite3DB& DB, const std::string_view&)
+{
+    const auto stats = DB.statementStatistics();
+    std::cout << "Cached statements: " << stats.size << "/" << stats.capacity << "\n";
+    std::cout << "Hits: " << stats.hits << ", misses: " << stats.misses << ", evictions: " << stats.evictions << "\n";
+}
+
+//Prints the query result cache counters
+void resultStatistics(sqlite3DB& DB, const std::string_view&)
+{
+    const auto cache = DB.resultCache();
+    if (cache == nullptr)
+    {
+        std::cout << "The result cache is disabled.\n";
+        return;
+    }
+    const auto stats = cache->getStatistics();
+    const uint64_t lookups = stats.hits + stats.misses;
+    std::cout << "Cached results: " << stats.size << ", " << stats.bytes << "/" << stats.budget << " bytes\n";
+    std::cout << "Hits: " << stats.hits << ", misses: " << stats.misses << " (" << (lookups == 0 ? 0 : stats.hits * 100 / lookups) << "% hit rate)"
+        << ", invalidations: " << stats.invalidations << ", evictions: " << stats.evictions << "\n";
+}
+
+//Prints the query plan of a statement, marking the steps which scan a whole table
+void queryPlan(sqlite3DB& DB, const std::string_view& args)
+{
+    const auto [status, plan] = DB.query("EXPLAIN QUERY PLAN " + std::string(args), {});
+    if (!status)
+    {
+        std::cout << "Error explaining statement.\n";
+        return;
+    }
+    printResult(plan);
+
+    const auto [scanStatus, scans] = DB.fullScans(args);
+    for (const auto& i : scans)
+    {
+        std::cout << "Full scan of " << i.table << " (~" << i.rows << " rows).\n";
+    }
 }
 
 //Creates the list of control sequences and associated function pointers
-std::unordered_map<std::string, std::function<void(sqlite3DB&, const std::string_view&)>> generateControlSequences()
+std::unordered_map<std::string, std::function<void(sqlite3DB&, const std::string_view&)>> generateControlSequences(databaseSettings& settings)
 {
-    decltype(generateControlSequences()) ret;
+    decltype(generateControlSequences(settings)) ret;
     ret["dt"] = displayTables;
     ret["dr"] = displayRows;
     ret["ax"] = autoexec;
-    ret["ld"] = load;
+    ret["ld"] = [&settings](sqlite3DB& DB, const std::string_view& args) { load(DB, settings, args); };
+    ret["sc"] = statementStatistics;
+    ret["rc"] = resultStatistics;
+    ret["bm"] = benchmarkStorage;
+    ret["bs"] = benchmarkServiceSearch;
+    ret["ps"] = benchmarkPartSearch;
+    ret["cr"] = benchmarkConcurrentReads;
+    ret["qp"] = queryPlan;
     return ret;
 }
 
 //Handles the database "console", always runs before the web-based portion of the system
 //Exited by entering "\\" - double backslash
-void db()
+//Loading a file (\ld) updates the settings to match
+void db(databaseSettings& settings)
 {
-    const auto sequences = generateControlSequences();
+    const auto sequences = generateControlSequences(settings);
     std::string input;
 
     while (true)
@@ -178,23 +242,117 @@ void db()
     }
 }
 
-int main()      
+//Reads the database settings from the command line, anything not given keeps its default
+//--db <file> opens a file-backed database, otherwise the database is held in memory
+//--mmap <bytes>, --cache <pages, or -KiB>, --temp-store <0|1|2> and --checkpoint <seconds> tune file-backed storage
+//--snapshot <file> and --snapshot-interval <seconds> keep an in-memory database's image on disk
+//--db-threads <count> sets how many threads run routes' database work
+//--plan-audit <rows> reports every statement which scans a table of at least that many rows, as it is first prepared
+//--result-cache <bytes> sets how much memory cached query results may use, 0 disables the cache
+databaseSettings readSettings(int argc, char** argv)
+{
+    databaseSettings ret;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        const std::string_view name = argv[i];
+        const std::string_view value = argv[i + 1];
+
+        int64_t number = 0;
+        const auto parsed = std::from_chars(value.data(), value.data() + value.size(), number);
+        const bool isNumber = parsed.ec == std::errc() && parsed.ptr == value.data() + value.size();
+
+        if (name == "--db")
+            ret.file = value;
+        else if (name == "--mmap" && isNumber)
+            ret.mmapSize = number;
+        else if (name == "--cache" && isNumber)
+            ret.cacheSize = number;
+        else if (name == "--temp-store" && isNumber)
+            ret.tempStore = static_cast<int>(number);
+        else if (name == "--checkpoint" && isNumber)
+            ret.checkpointInterval = std::chrono::seconds(number);
+        else if (name == "--snapshot")
+            ret.snapshotFile = value;
+        else if (name == "--snapshot-interval" && isNumber)
+            ret.snapshotInterval = std::chrono::seconds(number);
+        else if (name == "--db-threads" && isNumber && number > 0)
+            ret.executorThreads = static_cast<size_t>(number);
+        else if (name == "--plan-audit" && isNumber)
+            ret.planAuditRows = number;
+        else if (name == "--result-cache" && isNumber && number >= 0)
+            ret.resultCacheBytes = static_cast<size_t>(number);
+        else
+            std::cout << "Ignoring invalid option \"" << name << " " << value << "\".\n";
+    }
+    return ret;
+}
+
+int main(int argc, char** argv)
 {
-    sqlite3DB DB(nullptr);
+    databaseSettings settings = readSettings(argc, argv);
+
+    //Read connections only share a file-backed database, an in-memory one is read through this connection
+    sqlite3DB DB(settings.source());
     {
-        if (!DB.isOpen())
+        if (!DB.isOpen() || !DB.configure(settings))
         {
             std::cout << "Failed to open database.\n";
             std::cin.ignore();
             std::terminate();
         }
     }
+    DB.auditPlans(settings.planAuditRows);
+    //Every write goes through this connection, so it sees every change to the tables
+    DB.trackTables(serverData::tableNames);
+    DB.enableResultCache(settings.resultCacheBytes);
     serverData::database = &DB;
     authenticator auth;
     serverData::auth = &auth;
 
+    //An in-memory database picks up where the last snapshot left off
+    if (!settings.isFileBacked() && !settings.snapshotFile.empty() && std::filesystem::exists(settings.snapshotFile))
+    {
+        const auto start = std::chrono::steady_clock::now();
+        if (!DB.restore(settings.snapshotFile))
+        {
+            std::cout << "Failed to load snapshot \"" << settings.snapshotFile << "\".\n";
+        }
+        else
+        {
+            const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            std::cout << "Loaded snapshot \"" << settings.snapshotFile << "\" in " << elapsed.count() << "ms.\n";
+        }
+    }
+
     std::cout << "Database ready:\n";
-    db();
+    db(settings);
+
+    //Background work starts only once the console is done, as it may have moved the server onto another file
+    //Checkpoints use their own connection so they never hold up the network thread
+    std::optional<periodicTask> checkpointer;
+    if (settings.isFileBacked() && settings.checkpointInterval.count() > 0)
+    {
+        auto connection = std::make_shared<sqlite3DB>(std::string_view(settings.file));
+        checkpointer.emplace(settings.checkpointInterval, [connection]()
+            {
+                if (!connection->checkpoint())
+                    std::cout << "Background checkpoint failed.\n";
+            });
+    }
+
+    //An in-memory database keeps its snapshot up to date
+    const bool snapshots = !settings.isFileBacked() && !settings.snapshotFile.empty();
+    std::optional<periodicTask> snapshotter;
+    if (snapshots && settings.snapshotInterval.count() > 0)
+    {
+        snapshotter.emplace(settings.snapshotInterval, [&DB, &settings]()
+            {
+                const SQLCode result = DB.snapshot(settings.snapshotFile);
+                //A busy database is simply caught by the next snapshot
+                if (!result && result.errorCode != SQLITE_BUSY)
+                    std::cout << "Failed to write snapshot.\n";
+            });
+    }
 
     //Always ensure an empty database is given an admin user, otherwise indicate that one already exists.
     auto [status, result] = DB.query("INSERT INTO USERS(ID, USERNAME, PASSWORD, PERMISSIONS) VALUES(0, \"ADMIN\", :HAS, 3);", { {":HAS", auth.hash("ADMIN")} });
@@ -203,6 +361,13 @@ int main()
         std::cout << "Admin user not added.\n";
     }
 
-    net();
+    net(settings);
+
+    if (snapshots)
+    {
+        snapshotter.reset();
+        if (!DB.snapshot(settings.snapshotFile))
+            std::cout << "Failed to write snapshot.\n";
+    }
     std::cin.ignore();
-}
\ No newline at end of file
+}
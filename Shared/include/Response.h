@@ -385,4 +385,84 @@ public:
 
         return fromData(data);
     }
+};
+
+//Serializes a response holding a single list of objects one object at a time, without keeping the objects themselves
+//The text produced is identical to adding every object to a responseWrapper under the same key (then any fields given to finish) and calling toData(false)
+class responseListWriter
+{
+    std::string buffer;
+    std::string key;
+    //Unforced lists with a single object are written without brackets, so the first object is held until a second arrives
+    std::string pending;
+    size_t count = 0;
+    bool forceArray;
+
+public:
+    responseListWriter(std::string_view listKey, bool forced = false) : key(listKey), forceArray(forced) {}
+
+    void add(const responseWrapper& value)
+    {
+        if (count == 0)
+        {
+            buffer += '{';
+            buffer += key;
+            buffer += ':';
+            if (forceArray)
+                buffer += '[';
+            else
+            {
+                pending = value.toData(false);
+                count++;
+                return;
+            }
+        }
+        else if (count == 1 && !forceArray)
+        {
+            buffer += '[';
+            buffer += pending;
+            buffer += ',';
+            pending.clear();
+        }
+        else
+        {
+            buffer += ',';
+        }
+        buffer += value.toData(false);
+        count++;
+    }
+
+    size_t size() const { return count; }
+    //Text that is ready to be sent
+    size_t bufferedBytes() const { return buffer.size(); }
+
+    //Removes and returns any text that is ready to be sent
+    std::string take()
+    {
+        std::string ret;
+        std::swap(ret, buffer);
+        return ret;
+    }
+
+    //Closes the list, followed by any other fields of the response, and returns the remaining text
+    std::string finish(const responseWrapper& fields = responseWrapper())
+    {
+        if (count == 0)
+            buffer += '{';
+        else if (count == 1 && !forceArray)
+            buffer += pending;
+        else
+            buffer += ']';
+
+        //The fields' own braces are dropped, leaving their elements to follow the list
+        const std::string trailing = fields.toData(false);
+        if (trailing.size() > 2)
+        {
+            if (count != 0)
+                buffer += ',';
+            buffer.append(trailing, 1, trailing.size() - 2);
+        }
+        buffer += '}';
+        return take();
+    }
 };
\ No newline at end of file
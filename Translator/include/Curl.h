@@ -2,6 +2,9 @@
 #include <curl/curl.h>
 #include <vector>
 #include <string>
+#include <unordered_map>
+#include <mutex>
+#include <optional>
 
 //A wrapper around a single curl instance, adding RAII semantics
 class curlwrapper
@@ -137,9 +140,21 @@ struct APIResponse
     static constexpr auto allowedHeaders =
     {
         "Set-Cookie",
-        "cookie"
+        "cookie",
+        "ETag"
     };
 
+    //The value of a header kept from the response, if present
+    std::optional<std::string> getHeader(std::string_view name) const
+    {
+        for (const auto& i : headers)
+        {
+            if (i.first == name)
+                return i.second;
+        }
+        return std::nullopt;
+    }
+
     void bind(curlwrapper& curl) noexcept
     {
         curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
@@ -182,6 +197,67 @@ struct APIResponse
     }
 };
 
+//The last successful answer to each GET request (by URL and cookies) which came with an entity tag
+//Repeating the request sends the tag, and a Not Modified answer is then served from the stored body rather than sent again
+class validatorCache
+{
+    struct entry
+    {
+        std::string tag;
+        std::string body;
+        long code = 0;
+    };
+
+    std::unordered_map<std::string, entry> entries;
+    std::mutex lock;
+
+public:
+    //Once full, an arbitrary entry makes way for each new one
+    static constexpr size_t capacity = 1024;
+
+    static validatorCache& instance()
+    {
+        static validatorCache ret;
+        return ret;
+    }
+
+    std::optional<std::string> getTag(const std::string& key)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        const auto it = entries.find(key);
+        if (it == entries.end())
+            return std::nullopt;
+        return it->second.tag;
+    }
+
+    //Replaces a Not Modified answer's (empty) body and code with those stored, fails if nothing is stored for the key
+    bool restore(const std::string& key, APIResponse& response)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        const auto it = entries.find(key);
+        if (it == entries.end())
+            return false;
+        response.response = it->second.body;
+        response.response_code = it->second.code;
+        return true;
+    }
+
+    //Keeps the response if it carries a tag, otherwise forgets any response kept for the key
+    void update(const std::string& key, const APIResponse& response)
+    {
+        const auto tag = response.getHeader("ETag");
+        std::lock_guard<std::mutex> guard(lock);
+        if (!tag.has_value())
+        {
+            entries.erase(key);
+            return;
+        }
+        if (entries.size() >= capacity && entries.count(key) == 0)
+            entries.erase(entries.begin());
+        entries[key] = { tag.value(), response.response, response.response_code };
+    }
+};
+
 //A nicely formatted HTTP request, can be reassigned or divided between POST/GET requests
 //Potentially may be made asynchronous
 class requestWrapper
@@ -194,6 +270,17 @@ class requestWrapper
 
     APIResponse response;
     curlwrapper curl;
+    //Identify the request to the validator cache
+    std::string URL, cookies;
+    //Extra request headers, owned here as curl only refers to them
+    curl_slist* requestHeaders = nullptr;
+
+    void setHeaders(curl_slist* headers)
+    {
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+        curl_slist_free_all(requestHeaders);
+        requestHeaders = headers;
+    }
 
     static curlwrapper bind(APIResponse& response, std::string_view URL)
     {
@@ -214,7 +301,7 @@ class requestWrapper
 
 public:
     requestWrapper() = delete;
-    requestWrapper(std::string_view URL)
+    requestWrapper(std::string_view target) : URL(target)
     {
         curl = bind(response, URL);
     }
@@ -227,33 +314,64 @@ public:
     {
         curl = std::move(other.curl);
         response.bind(curl);
+        std::swap(URL, other.URL);
+        std::swap(cookies, other.cookies);
+        std::swap(requestHeaders, other.requestHeaders);
         return *this;
     }
 
+    ~requestWrapper()
+    {
+        curl_slist_free_all(requestHeaders);
+    }
+
     //Overwrites any existing cookies
     void setCookies(const std::string& values)
     {
-        curl_easy_setopt(curl, CURLOPT_COOKIE, values.c_str());
+        cookies = values;
+        curl_easy_setopt(curl, CURLOPT_COOKIE, cookies.c_str());
     }
 
-    void retarget(const std::string& URL)
+    void retarget(const std::string& target)
     {
+        URL = target;
         curl_easy_setopt(curl, CURLOPT_URL, URL.data());
     }
 
     const APIResponse& post(std::string_view data)
     {
+        setHeaders(nullptr);
         curl_easy_setopt(curl, CURLOPT_POSTFIELDS, data.data());
         curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, data.size());
         perform();
         return response;
     }
 
+    //Revalidates any response already held for the same request, which the server then need not send again
     const APIResponse& get()
     {
+        //Responses may differ between sessions, so each session's are kept apart
+        const std::string key = URL + '\n' + cookies;
+        const auto tag = validatorCache::instance().getTag(key);
+        setHeaders(tag.has_value() ? curl_slist_append(nullptr, ("If-None-Match: " + tag.value()).c_str()) : nullptr);
+
         curl_easy_setopt(curl, CURLOPT_POSTFIELDS, nullptr);
         curl_easy_setopt(curl, CURLOPT_HTTPGET, true);
         perform();
+
+        if (response.response_code == 304 && tag.has_value())
+        {
+            //The held copy is still current
+            if (validatorCache::instance().restore(key, response))
+                return response;
+            //The copy was evicted after its tag was sent, so the whole response is asked for again
+            response.response.clear();
+            response.headers.clear();
+            setHeaders(nullptr);
+            perform();
+        }
+        if (response.response_code == 200)
+            validatorCache::instance().update(key, response);
         return response;
     }
 };
\ No newline at end of file